@@ -0,0 +1,131 @@
+// Automatic player: tries every reachable placement of the current and next piece,
+// scores the resulting boards and returns the inputs for the best placement.
+// Works on row masks only, so it runs without SFML and on any thread.
+#pragma once
+
+#include "engine.hpp"
+#include "features.hpp"
+#include "movegen.hpp"
+#include "threadpool.hpp"
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// Linear evaluation weights, the well-known set tuned by Yiyuan Lee for this feature set
+struct BotWeights {
+    float aggregateHeight = -0.510066f;
+    float linesCleared = 0.760666f;
+    float holes = -0.35663f;
+    float bumpiness = -0.184483f;
+};
+
+inline float evaluateFeatures(const BoardFeatureSet& f, int lines, const BotWeights& weights) {
+    return weights.aggregateHeight * f.aggregateHeight + weights.linesCleared * lines +
+           weights.holes * f.holes + weights.bumpiness * f.bumpiness;
+}
+
+inline float evaluateBoard(const BoardRows& rows, int lines, const BotWeights& weights) {
+    return evaluateFeatures(extractFeatures(rows), lines, weights);
+}
+
+// Writes the piece into the rows and clears lines; returns the lines cleared
+inline int lockPlacement(BoardRows& rows, char shape, const Placement& placement) {
+    const ShapeRotation& r = shapeRotation(shape, placement.rotation);
+    for (const Cell& c : r.cells) {
+        int y = placement.y + c.y;
+        if (y >= 0) rows[y] |= static_cast<RowMask>(1u << (placement.x + c.x));
+    }
+    return clearFullRowMasks(rows);
+}
+
+// Two-piece lookahead search. Current-piece candidates are scored in parallel,
+// each one trying every placement of the next piece on the resulting board.
+class PlacementSearch {
+public:
+    // threads: 0 for one per core, 1 to search on the calling thread
+    explicit PlacementSearch(int threads = 1, BotWeights botWeights = BotWeights()) : weights(botWeights) {
+        if (threads != 1) {
+            pool = std::make_unique<ThreadPool>(threads);
+        }
+    }
+
+    // Boards evaluated since construction
+    long long nodes() const { return nodeCount.load(); }
+
+    Placement best(const BoardRows& rows, const Piece& current, const Piece& next) {
+        std::vector<Placement> candidates;
+        rootMoves.generate(rows, current, [&](const Placement& p) { candidates.push_back(p); });
+        std::vector<float> scores(candidates.size());
+
+        auto scoreCandidate = [&](size_t i) {
+            BoardRows after = rows;
+            int lines = lockPlacement(after, current.shape, candidates[i]);
+            long long visited = 1;
+            float bestNext = LOST;
+            if (candidates[i].y >= 0 && rowsFit(after, shapeRotation(next.shape, next.rotation).rows,
+                                                shapeRotation(next.shape, next.rotation).height, next.x, next.y)) {
+                // Land every next-piece placement first, then score the boards in feature batches
+                MoveGenerator nextMoves;
+                std::vector<BoardRows> landed;
+                std::vector<int> landedLines;
+                nextMoves.generate(after, next, [&](const Placement& p) {
+                    visited++;
+                    if (p.y < 0) return;
+                    landed.push_back(after);
+                    landedLines.push_back(lines + lockPlacement(landed.back(), next.shape, p));
+                });
+                std::vector<BoardFeatureSet> features(landed.size());
+                extractFeatures(landed.data(), landed.size(), features.data());
+                for (size_t j = 0; j < landed.size(); ++j) {
+                    bestNext = std::max(bestNext, evaluateFeatures(features[j], landedLines[j], weights));
+                }
+            }
+            scores[i] = bestNext;
+            nodeCount += visited;
+        };
+        if (pool) {
+            pool->parallelFor(candidates.size(), scoreCandidate);
+        } else {
+            for (size_t i = 0; i < candidates.size(); ++i) scoreCandidate(i);
+        }
+
+        Placement chosen;
+        float bestScore = -std::numeric_limits<float>::infinity();
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (scores[i] > bestScore) {
+                bestScore = scores[i];
+                chosen = candidates[i];
+            }
+        }
+        return chosen;
+    }
+
+    // Inputs that take the piece from the last best() call to the placement and lock it
+    std::vector<Input> inputsFor(const Placement& placement) {
+        return rootMoves.pathTo(placement);
+    }
+
+private:
+    static constexpr float LOST = -1e9f; // the next piece can't spawn, or the piece locked above the board
+    BotWeights weights;
+    std::unique_ptr<ThreadPool> pool;
+    MoveGenerator rootMoves;
+    std::atomic<long long> nodeCount{0};
+};
+
+// Plays the engine's current game with the search until it ends or maxPieces are placed.
+// Every piece is placed straight away; gravity never gets a turn.
+inline void playBotPieces(TetrisEngine& engine, PlacementSearch& search, int maxPieces) {
+    while (!engine.gameOver && engine.blocksPlaced < maxPieces) {
+        Placement placement = search.best(engine.board.occupancy(), engine.currentPiece, engine.nextPiece);
+        if (!placement.valid) {
+            engine.hardDrop(); // nowhere to go, lock where it spawned
+            continue;
+        }
+        for (Input input : search.inputsFor(placement)) {
+            engine.apply(input);
+        }
+    }
+}
@@ -0,0 +1,62 @@
+// Heap allocation counter. Replaces the global operator new/delete, so it must be included by
+// exactly one translation unit (main.cpp, directly and through alloccheck.hpp).
+#pragma once
+
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// Calls to operator new (any form) made by this thread. Per thread, so the audio and
+// worker threads don't show up in the main loop's per-frame counts.
+inline thread_local long long heapAllocations = 0;
+
+inline long long allocationCount() {
+    return heapAllocations;
+}
+
+inline void* countedAllocate(std::size_t size) {
+    ++heapAllocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) { return countedAllocate(size); }
+void* operator new[](std::size_t size) { return countedAllocate(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+inline void* countedAllocateAligned(std::size_t size, std::align_val_t alignment) {
+    ++heapAllocations;
+    std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+    void* p = _aligned_malloc(size ? size : 1, align); // MSVC has no std::aligned_alloc
+#else
+    void* p = std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+    if (p) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// Memory from _aligned_malloc must go back through _aligned_free
+inline void freeAligned(void* p) noexcept {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) { return countedAllocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return countedAllocateAligned(size, alignment); }
+void operator delete(void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
@@ -0,0 +1,86 @@
+// Steady-state allocation check: after a warm-up, no frame of the game loop may touch the heap.
+// Usage: tetris --headless --alloc-check [--frames N] [--warmup N] [--seed S]   (simulation ticks only)
+//        tetris --alloc-check [--frames N] [--warmup N]                         (update() and draw() too)
+// Exits with 1 if any measured frame allocated.
+#pragma once
+
+#include "allocations.hpp"
+#include "simulation.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+struct AllocationCheckOptions {
+    long long warmupFrames = 600; // enough for the first locks, line clears and a game over
+    long long frames = 20000;
+    uint32_t seed = 1;
+};
+
+inline AllocationCheckOptions parseAllocationCheckOptions(int argc, char** argv) {
+    AllocationCheckOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--frames" && hasValue) options.frames = std::max(1LL, std::atoll(argv[++i]));
+        else if (arg == "--warmup" && hasValue) options.warmupFrames = std::max(0LL, std::atoll(argv[++i]));
+        else if (arg == "--seed" && hasValue) options.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    return options;
+}
+
+// Runs frame(i) for the warm-up and then the measured frames, counting this thread's
+// allocations in each measured one. Prints the first offenders and a summary.
+template<class Frame>
+bool checkFrameAllocations(const AllocationCheckOptions& options, Frame&& frame) {
+    for (long long i = 0; i < options.warmupFrames; ++i) {
+        frame(i);
+    }
+    long long allocatingFrames = 0, allocations = 0, worst = 0;
+    for (long long i = options.warmupFrames; i < options.warmupFrames + options.frames; ++i) {
+        long long before = allocationCount();
+        frame(i);
+        long long count = allocationCount() - before;
+        if (count > 0) {
+            if (allocatingFrames < 10) {
+                std::cerr << "frame " << i << ": " << count << " allocation" << (count == 1 ? "" : "s") << std::endl;
+            }
+            allocatingFrames++;
+            allocations += count;
+            worst = std::max(worst, count);
+        }
+    }
+    std::cout << "frames: " << options.frames << " after " << options.warmupFrames << " warm-up" << std::endl;
+    std::cout << "allocating frames: " << allocatingFrames << std::endl;
+    std::cout << "allocations: " << allocations << " (worst frame " << worst << ")" << std::endl;
+    return allocatingFrames == 0;
+}
+
+// The scripted input every eighth frame used by both checks: moves, rotations and hard drops,
+// so pieces lock, lines clear now and then and games end and restart
+inline Input allocationCheckInput(long long frame) {
+    const Input inputs[4] = {Input::Left, Input::Rotate, Input::Right, Input::HardDrop};
+    return frame % 8 == 0 ? inputs[(frame / 8) % 4] : Input::None;
+}
+
+// Simulation ticks and snapshot copies, as the windowed game runs them inline
+inline int runSimulationAllocationCheck(int argc, char** argv) {
+    AllocationCheckOptions options = parseAllocationCheckOptions(argc, argv);
+    TetrisEngine engine(options.seed);
+    Simulation simulation(engine, 60);
+    GameSnapshot snapshot;
+    uint32_t games = 0;
+    simulation.reset(options.seed);
+    bool ok = checkFrameAllocations(options, [&](long long i) {
+        if (snapshot.gameOver) {
+            simulation.reset(options.seed + ++games);
+        }
+        if (Input input = allocationCheckInput(i); input != Input::None) {
+            simulation.queueInput(input);
+        }
+        simulation.advance(simulation.tickSeconds());
+        simulation.latest(snapshot);
+    });
+    std::cout << "games: " << games + 1 << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,415 @@
+// Engine and audio micro-benchmarks
+// Usage: tetris --headless --bench-board [--iterations N]
+//        tetris --headless --bench-synth [--iterations N]
+//        tetris --headless --bench-movegen [--iterations N]
+//        tetris --headless --bench-features [--iterations N]
+#pragma once
+
+#include "engine.hpp"
+#include "features.hpp"
+#include "movegen.hpp"
+#include "synth.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+// The board and shape code as it was before the bitmask and table rewrites, kept as the benchmark baseline
+using LegacyBoard = std::vector<std::vector<uint32_t>>;
+
+const std::array<std::pair<char, ShapeMatrix>, 7> LEGACY_SHAPES = {{
+    {'I', {{1,1,1,1}}},
+    {'J', {{1,0,0},{1,1,1}}},
+    {'L', {{0,0,1},{1,1,1}}},
+    {'O', {{1,1},{1,1}}},
+    {'S', {{0,1,1},{1,1,0}}},
+    {'T', {{0,1,0},{1,1,1}}},
+    {'Z', {{1,1,0},{0,1,1}}}
+}};
+
+inline ShapeMatrix legacyGetShapeMatrix(const TetrisEngine& engine, char shape, int rotation) {
+    ShapeMatrix matrix;
+    for (const auto& s : LEGACY_SHAPES) {
+        if (s.first == shape) {
+            matrix = s.second;
+            break;
+        }
+    }
+    for (int i = 0; i < rotation; ++i) {
+        matrix = engine.rotateShape(matrix);
+    }
+    return matrix;
+}
+
+inline bool legacyValidPosition(const LegacyBoard& board, const ShapeMatrix& matrix, int px, int py) {
+    for (int y = 0; y < (int)matrix.size(); ++y) {
+        for (int x = 0; x < (int)matrix[y].size(); ++x) {
+            if (matrix[y][x]) {
+                int newX = px + x;
+                int newY = py + y;
+                if (newX < 0 || newX >= BOARD_WIDTH || newY >= BOARD_HEIGHT)
+                    return false;
+                if (newY >= 0 && board[newY][newX] != EMPTY_CELL)
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+inline int legacyClearLines(LegacyBoard& board) {
+    int cleared = 0;
+    for (int y = BOARD_HEIGHT - 1; y >= 0; --y) {
+        bool fullLine = true;
+        for (int x = 0; x < BOARD_WIDTH; ++x) {
+            if (board[y][x] == EMPTY_CELL) {
+                fullLine = false;
+                break;
+            }
+        }
+        if (fullLine) {
+            for (int row = y; row > 0; --row) {
+                board[row] = board[row - 1];
+            }
+            board[0] = std::vector<uint32_t>(BOARD_WIDTH, EMPTY_CELL);
+            ++cleared;
+            ++y; // recheck this row
+        }
+    }
+    return cleared;
+}
+
+// Seconds taken by body(i) for i in [0, iterations)
+template<class Body>
+double timeLoop(long long iterations, Body body) {
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < iterations; ++i) {
+        body(i);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline void printBenchLine(const std::string& name, long long iterations, double legacySeconds, double currentSeconds) {
+    std::cout << name << ": legacy " << iterations / legacySeconds / 1e6 << " Mops/s, current "
+              << iterations / currentSeconds / 1e6 << " Mops/s, speedup "
+              << legacySeconds / currentSeconds << "x" << std::endl;
+}
+
+inline int runBoardBenchmark(int argc, char** argv) {
+    long long iterations = 2000000;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1LL, std::atoll(argv[++i]));
+        }
+    }
+
+    // A half-filled board from a fixed seed so both representations see the same cells
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> coin(0, 1);
+    LegacyBoard legacy(BOARD_HEIGHT, std::vector<uint32_t>(BOARD_WIDTH, EMPTY_CELL));
+    Board board;
+    for (int y = BOARD_HEIGHT / 2; y < BOARD_HEIGHT; ++y) {
+        for (int x = 0; x < BOARD_WIDTH; ++x) {
+            if (coin(rng)) {
+                legacy[y][x] = 0xFFFFFFFF;
+                board.set(x, y, 0xFFFFFFFF);
+            }
+        }
+    }
+
+    // The compile-time tables must agree with the old rotateShape path
+    TetrisEngine engine(0);
+    engine.board = board;
+    std::vector<ShapeMatrix> matrices;
+    std::vector<std::array<uint32_t, 4>> masks;
+    for (char shape : SHAPE_NAMES) {
+        for (int rot = 0; rot < 4; ++rot) {
+            ShapeMatrix matrix = legacyGetShapeMatrix(engine, shape, rot);
+            if (matrix != engine.getShapeMatrix(Piece{shape, rot, 0, 0, 0})) {
+                std::cerr << "Rotation table differs for " << shape << " rotation " << rot << std::endl;
+                return 1;
+            }
+            const ShapeRotation& r = shapeRotation(shape, rot);
+            matrices.push_back(matrix);
+            masks.push_back({r.rows[0], r.rows[1], r.rows[2], r.rows[3]});
+        }
+    }
+
+    // Collision: every shape and rotation at every column and row
+    const int positions = (BOARD_WIDTH + 3) * (BOARD_HEIGHT + 2);
+    long long fitsLegacy = 0, fitsBitboard = 0;
+    double legacyCollision = timeLoop(iterations, [&](long long i) {
+        size_t shape = i % matrices.size();
+        int pos = (i / matrices.size()) % positions;
+        fitsLegacy += legacyValidPosition(legacy, matrices[shape], pos % (BOARD_WIDTH + 3) - 2, pos / (BOARD_WIDTH + 3) - 2);
+    });
+    double bitboardCollision = timeLoop(iterations, [&](long long i) {
+        size_t shape = i % masks.size();
+        int pos = (i / masks.size()) % positions;
+        fitsBitboard += board.fits(masks[shape].data(), (int)matrices[shape].size(), pos % (BOARD_WIDTH + 3) - 2, pos / (BOARD_WIDTH + 3) - 2);
+    });
+    if (fitsLegacy != fitsBitboard) {
+        std::cerr << "Collision results differ: " << fitsLegacy << " vs " << fitsBitboard << std::endl;
+        return 1;
+    }
+
+    // Full piece query: rebuilding the rotated matrix every call versus the table lookup
+    long long queryLegacy = 0, queryTable = 0;
+    double legacyQuery = timeLoop(iterations, [&](long long i) {
+        int pos = (i / 28) % positions;
+        ShapeMatrix matrix = legacyGetShapeMatrix(engine, SHAPE_NAMES[i % 7], (i / 7) % 4);
+        queryLegacy += legacyValidPosition(legacy, matrix, pos % (BOARD_WIDTH + 3) - 2, pos / (BOARD_WIDTH + 3) - 2);
+    });
+    double tableQuery = timeLoop(iterations, [&](long long i) {
+        int pos = (i / 28) % positions;
+        Piece piece{SHAPE_NAMES[i % 7], static_cast<int>((i / 7) % 4), 0, pos % (BOARD_WIDTH + 3) - 2, pos / (BOARD_WIDTH + 3) - 2};
+        queryTable += engine.validPosition(piece);
+    });
+    if (queryLegacy != queryTable) {
+        std::cerr << "Piece query results differ: " << queryLegacy << " vs " << queryTable << std::endl;
+        return 1;
+    }
+
+    // Clearing: four full rows under the random cells, restored every iteration
+    const long long clearIterations = std::max(1LL, iterations / 10);
+    for (int y = BOARD_HEIGHT - 4; y < BOARD_HEIGHT; ++y) {
+        for (int x = 0; x < BOARD_WIDTH; ++x) {
+            legacy[y][x] = 0xFFFFFFFF;
+            board.set(x, y, 0xFFFFFFFF);
+        }
+    }
+    long long clearedLegacy = 0, clearedBitboard = 0;
+    LegacyBoard legacyWork;
+    double legacyClear = timeLoop(clearIterations, [&](long long) {
+        legacyWork = legacy;
+        clearedLegacy += legacyClearLines(legacyWork);
+    });
+    Board boardWork;
+    double bitboardClear = timeLoop(clearIterations, [&](long long) {
+        boardWork = board;
+        clearedBitboard += boardWork.clearFullRows();
+    });
+    if (clearedLegacy != clearedBitboard) {
+        std::cerr << "Clear results differ: " << clearedLegacy << " vs " << clearedBitboard << std::endl;
+        return 1;
+    }
+
+    printBenchLine("board collision", iterations, legacyCollision, bitboardCollision);
+    printBenchLine("validPosition", iterations, legacyQuery, tableQuery);
+    printBenchLine("clearLines", clearIterations, legacyClear, bitboardClear);
+    return 0;
+}
+
+// The theme loop exactly as generateTetrisTheme rendered it at startup, with std::sin per sample
+inline void legacyGenerateTheme(std::vector<int16_t>& samples) {
+    const int noteSamples = ThemeSynth::samplesPerNote(1.0f);
+    samples.clear();
+    for (float freq : THEME_MELODY) {
+        for (int i = 0; i < noteSamples; ++i) {
+            samples.push_back(ThemeSynth::noteSample(freq, i, noteSamples));
+        }
+    }
+}
+
+// Iterations are whole theme loops; the synth renders in stream-sized chunks
+inline int runSynthBenchmark(int argc, char** argv) {
+    long long iterations = 50;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1LL, std::atoll(argv[++i]));
+        }
+    }
+
+    const size_t CHUNK = 4096;
+    std::vector<int16_t> legacy;
+    legacyGenerateTheme(legacy);
+    std::vector<int16_t> current(legacy.size());
+
+    long long checksumLegacy = 0, checksumCurrent = 0;
+    double legacySeconds = timeLoop(iterations, [&](long long) {
+        legacyGenerateTheme(legacy);
+        checksumLegacy += legacy[legacy.size() / 3];
+    });
+    ThemeSynth synth;
+    double currentSeconds = timeLoop(iterations, [&](long long) {
+        synth.restart();
+        for (size_t offset = 0; offset < current.size(); offset += CHUNK) {
+            synth.render(current.data() + offset, std::min(CHUNK, current.size() - offset));
+        }
+        checksumCurrent += current[current.size() / 3];
+    });
+
+    // The polynomial sine and float phase may round differently by a step or two, never more
+    int maxError = 0;
+    for (size_t i = 0; i < legacy.size(); ++i) {
+        maxError = std::max(maxError, std::abs(legacy[i] - current[i]));
+    }
+    if (maxError > 4) {
+        std::cerr << "Synth output differs from the legacy loop by " << maxError << std::endl;
+        return 1;
+    }
+
+    long long samples = iterations * static_cast<long long>(legacy.size());
+    std::cout << "theme synth: legacy " << samples / legacySeconds / 1e6 << " Msamples/s, current "
+              << samples / currentSeconds / 1e6 << " Msamples/s, speedup "
+              << legacySeconds / currentSeconds << "x, max error " << maxError
+              << " (checksums " << checksumLegacy << "/" << checksumCurrent << ")" << std::endl;
+    return 0;
+}
+
+// Lock positions reachable by rotating at spawn, shifting and dropping straight down,
+// the placements a bot without a move generator would consider
+inline int countDropPlacements(const BoardRows& rows, const Piece& piece) {
+    int count = 0;
+    bool seen[4] = {};
+    for (int rot = 0; rot < 4; ++rot) {
+        const ShapeRotation& r = shapeRotation(piece.shape, rot);
+        if (!rowsFit(rows, r.rows, r.height, piece.x, piece.y)) break;
+        int canonical = CANONICAL_ROTATIONS[shapeIndex(piece.shape)][rot];
+        if (seen[canonical]) continue;
+        seen[canonical] = true;
+        int minX = piece.x, maxX = piece.x;
+        while (rowsFit(rows, r.rows, r.height, minX - 1, piece.y)) --minX;
+        while (rowsFit(rows, r.rows, r.height, maxX + 1, piece.y)) ++maxX;
+        count += maxX - minX + 1;
+    }
+    return count;
+}
+
+// Mid-game boards with overhangs: random inputs, a gravity step every fourth input
+inline std::vector<std::pair<BoardRows, Piece>> samplePositions(size_t count) {
+    std::vector<std::pair<BoardRows, Piece>> positions;
+    TetrisEngine engine(1);
+    std::mt19937 rng(99);
+    std::uniform_int_distribution<int> inputDist(0, 5);
+    for (uint32_t game = 0; positions.size() < count; ++game) {
+        engine.reset(game);
+        for (int frame = 1; !engine.gameOver && positions.size() < count; ++frame) {
+            if (engine.apply(static_cast<Input>(inputDist(rng))) || frame % 4 == 0) {
+                if (!engine.gameOver) engine.stepDown();
+                positions.push_back({engine.board.occupancy(), engine.currentPiece});
+            }
+        }
+    }
+    return positions;
+}
+
+// Iterations are move generations, cycling through boards taken from random-input games
+inline int runMoveGenBenchmark(int argc, char** argv) {
+    long long iterations = 200000;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1LL, std::atoll(argv[++i]));
+        }
+    }
+
+    std::vector<std::pair<BoardRows, Piece>> positions = samplePositions(1000);
+    MoveGenerator generator;
+    long long placements = 0, dropPlacements = 0;
+    double seconds = timeLoop(iterations, [&](long long i) {
+        const auto& position = positions[i % positions.size()];
+        placements += generator.generate(position.first, position.second, [](const Placement&) {});
+    });
+    for (long long i = 0; i < iterations; ++i) {
+        const auto& position = positions[i % positions.size()];
+        dropPlacements += countDropPlacements(position.first, position.second);
+    }
+
+    std::cout << "move generator: " << generator.generations / seconds << " generations/s, "
+              << placements / seconds / 1e6 << " M placements/s, "
+              << static_cast<double>(placements) / iterations << " placements per piece ("
+              << static_cast<double>(dropPlacements) / iterations << " by straight drops)" << std::endl;
+    return 0;
+}
+
+// The straightforward version: walk every cell of every column and row
+inline BoardFeatureSet scanFeatures(const Board& board) {
+    BoardFeatureSet f;
+    for (int x = 0; x < BOARD_WIDTH; ++x) {
+        bool covered = false;
+        for (int y = 0; y < BOARD_HEIGHT; ++y) {
+            if (board[y][x] != EMPTY_CELL) {
+                if (!covered) f.heights[x] = BOARD_HEIGHT - y;
+                covered = true;
+            } else if (covered) {
+                f.holes++;
+            }
+        }
+        f.aggregateHeight += f.heights[x];
+        f.maxHeight = std::max(f.maxHeight, f.heights[x]);
+    }
+    for (int x = 0; x < BOARD_WIDTH; ++x) {
+        int left = x > 0 ? f.heights[x - 1] : BOARD_HEIGHT;
+        int right = x + 1 < BOARD_WIDTH ? f.heights[x + 1] : BOARD_HEIGHT;
+        int well = std::max(0, std::min(left, right) - f.heights[x]);
+        f.wellDepths += well;
+        f.maxWellDepth = std::max(f.maxWellDepth, well);
+        if (x > 0) f.bumpiness += std::abs(f.heights[x] - f.heights[x - 1]);
+    }
+    for (int y = BOARD_HEIGHT - f.maxHeight; y < BOARD_HEIGHT; ++y) {
+        bool previous = true; // left wall
+        for (int x = 0; x < BOARD_WIDTH; ++x) {
+            bool filled = board[y][x] != EMPTY_CELL;
+            f.rowTransitions += filled != previous;
+            previous = filled;
+        }
+        f.rowTransitions += !previous; // right wall
+    }
+    return f;
+}
+
+inline bool sameFeatures(const BoardFeatureSet& a, const BoardFeatureSet& b) {
+    for (int x = 0; x < BOARD_WIDTH; ++x) {
+        if (a.heights[x] != b.heights[x]) return false;
+    }
+    return a.aggregateHeight == b.aggregateHeight && a.maxHeight == b.maxHeight && a.holes == b.holes &&
+           a.bumpiness == b.bumpiness && a.wellDepths == b.wellDepths && a.maxWellDepth == b.maxWellDepth &&
+           a.rowTransitions == b.rowTransitions;
+}
+
+// Iterations are boards; both versions see the same boards from random-input games
+inline int runFeatureBenchmark(int argc, char** argv) {
+    long long iterations = 2000000;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1LL, std::atoll(argv[++i]));
+        }
+    }
+
+    const size_t BOARDS = 4096;
+    std::vector<BoardRows> masks;
+    std::vector<Board> boards(BOARDS);
+    for (const auto& position : samplePositions(BOARDS)) {
+        masks.push_back(position.first);
+    }
+    for (size_t i = 0; i < BOARDS; ++i) {
+        for (int y = 0; y < BOARD_HEIGHT; ++y)
+            for (int x = 0; x < BOARD_WIDTH; ++x)
+                if ((masks[i][y] >> x) & 1u) boards[i].set(x, y, 0xFFFFFFFF);
+    }
+
+    std::vector<BoardFeatureSet> scanned(BOARDS), batched(BOARDS);
+    const long long passes = std::max(1LL, iterations / static_cast<long long>(BOARDS));
+    long long checksum = 0;
+    double scanSeconds = timeLoop(passes, [&](long long) {
+        for (size_t i = 0; i < BOARDS; ++i) scanned[i] = scanFeatures(boards[i]);
+        checksum += scanned[passes % BOARDS].holes;
+    });
+    double batchSeconds = timeLoop(passes, [&](long long) {
+        extractFeatures(masks.data(), BOARDS, batched.data());
+        checksum += batched[passes % BOARDS].holes;
+    });
+    for (size_t i = 0; i < BOARDS; ++i) {
+        if (!sameFeatures(scanned[i], batched[i])) {
+            std::cerr << "Feature results differ on board " << i << std::endl;
+            return 1;
+        }
+    }
+
+    long long total = passes * static_cast<long long>(BOARDS);
+    std::cout << "board features: cell scan " << total / scanSeconds / 1e6 << " M boards/s, batched "
+              << total / batchSeconds / 1e6 << " M boards/s, speedup " << scanSeconds / batchSeconds
+              << "x (checksum " << checksum << ")" << std::endl;
+    return 0;
+}
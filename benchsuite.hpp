@@ -0,0 +1,267 @@
+// Benchmark suite: engine micro-benchmarks and whole-game macro-benchmarks, reported as JSON.
+// Every metric is nanoseconds per operation (lower is better), the median of several timed runs.
+// Usage: tetris_bench [--filter TEXT] [--repetitions R] [--scale F] [--out FILE]
+//                     [--compare BASELINE.json [--threshold PERCENT]]
+//        tetris --headless --bench-suite [same options]   (everything except the draw() frame)
+#pragma once
+
+#include "engine.hpp"
+#include "bench.hpp"
+#include "headless.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchmarkCase {
+    std::string name;
+    std::string kind;     // "micro" or "macro"
+    long long iterations; // operations per timed run, before --scale
+    std::function<double(long long)> run; // seconds for that many operations, setup excluded
+};
+
+struct BenchmarkResult {
+    std::string name;
+    std::string kind;
+    long long iterations = 0;
+    double nsPerOp = 0;
+};
+
+// Results feed this so the optimizer can't drop the work being timed
+inline volatile long long benchSink = 0;
+
+// Seconds spent in op(engine, i) for n operations that each need freshly restored state.
+// restore(engine, i) runs untimed: a batch of engines is restored, then op runs over the batch.
+template<class Restore, class Op>
+double timeRestored(long long n, Restore restore, Op op) {
+    const long long BATCH = 256;
+    std::vector<TetrisEngine> engines(BATCH, TetrisEngine(0));
+    double seconds = 0;
+    for (long long done = 0; done < n; done += BATCH) {
+        long long count = std::min(BATCH, n - done);
+        for (long long k = 0; k < count; ++k) restore(engines[k], done + k);
+        seconds += timeLoop(count, [&](long long k) { op(engines[k], done + k); });
+    }
+    for (const TetrisEngine& engine : engines) benchSink = benchSink + engine.linesCleared + engine.blocksPlaced;
+    return seconds;
+}
+
+inline std::vector<BenchmarkCase> engineBenchmarks() {
+    std::vector<BenchmarkCase> cases;
+
+    // validPosition: every shape and rotation swept over the board, half of which is filled
+    cases.push_back({"validPosition", "micro", 2000000, [](long long n) {
+        TetrisEngine engine(0);
+        std::mt19937 rng(42);
+        for (int y = BOARD_HEIGHT / 2; y < BOARD_HEIGHT; ++y) {
+            for (int x = 0; x < BOARD_WIDTH; ++x) {
+                if (rng() & 1) engine.board.set(x, y, 0xFFFFFFFF);
+            }
+        }
+        const int positions = (BOARD_WIDTH + 3) * (BOARD_HEIGHT + 2);
+        long long fits = 0;
+        double seconds = timeLoop(n, [&](long long i) {
+            int pos = (i / 28) % positions;
+            Piece piece{SHAPE_NAMES[i % 7], static_cast<int>((i / 7) % 4), 0, pos % (BOARD_WIDTH + 3) - 2, pos / (BOARD_WIDTH + 3) - 2};
+            fits += engine.validPosition(piece);
+        });
+        benchSink = benchSink + fits;
+        return seconds;
+    }});
+
+    cases.push_back({"getShapeMatrix", "micro", 1000000, [](long long n) {
+        TetrisEngine engine(0);
+        long long cells = 0;
+        double seconds = timeLoop(n, [&](long long i) {
+            cells += engine.getShapeMatrix(Piece{SHAPE_NAMES[i % 7], static_cast<int>((i / 7) % 4), 0, 0, 0}).size();
+        });
+        benchSink = benchSink + cells;
+        return seconds;
+    }});
+
+    cases.push_back({"rotateShape", "micro", 1000000, [](long long n) {
+        TetrisEngine engine(0);
+        std::vector<ShapeMatrix> shapes;
+        for (char shape : SHAPE_NAMES) shapes.push_back(engine.getShapeMatrix(Piece{shape, 0, 0, 0, 0}));
+        long long cells = 0;
+        double seconds = timeLoop(n, [&](long long i) {
+            cells += engine.rotateShape(shapes[i % shapes.size()]).size();
+        });
+        benchSink = benchSink + cells;
+        return seconds;
+    }});
+
+    // clearLines: four full rows under random cells, the board restored (untimed) before every clear
+    cases.push_back({"clearLines", "micro", 1000000, [](long long n) {
+        std::mt19937 rng(42);
+        Board board;
+        for (int y = BOARD_HEIGHT / 2; y < BOARD_HEIGHT; ++y) {
+            for (int x = 0; x < BOARD_WIDTH; ++x) {
+                if (y >= BOARD_HEIGHT - 4 || (rng() & 1)) board.set(x, y, 0xFFFFFFFF);
+            }
+        }
+        return timeRestored(n, [&](TetrisEngine& engine, long long) { engine.board = board; },
+                            [](TetrisEngine& engine, long long) { engine.clearLines(); });
+    }});
+
+    // placePiece: locks pieces at their landing spots on mid-game boards, restoring the board (untimed) each time
+    cases.push_back({"placePiece", "micro", 1000000, [](long long n) {
+        std::vector<std::pair<BoardRows, Piece>> positions = samplePositions(1000);
+        std::vector<std::pair<Board, Piece>> landings;
+        for (const auto& position : positions) {
+            TetrisEngine probe(0);
+            probe.board.setRows(position.first);
+            Piece piece = position.second;
+            while (probe.validPosition(piece, 0, 1)) piece.y++;
+            landings.push_back({probe.board, piece});
+        }
+        return timeRestored(n,
+            [&](TetrisEngine& engine, long long i) {
+                const auto& landing = landings[i % landings.size()];
+                engine.board = landing.first;
+                engine.currentPiece = landing.second;
+                engine.gameOver = false;
+            },
+            [](TetrisEngine& engine, long long) { engine.placePiece(); });
+    }});
+
+    // dropDistance: the hard drop and ghost landing row for pieces at their spawn spots on mid-game boards
+    cases.push_back({"dropDistance", "micro", 2000000, [](long long n) {
+        std::vector<std::pair<BoardRows, Piece>> positions = samplePositions(1000);
+        std::vector<TetrisEngine> engines(positions.size(), TetrisEngine(0));
+        for (size_t i = 0; i < positions.size(); ++i) {
+            engines[i].board.setRows(positions[i].first);
+        }
+        long long rows = 0;
+        double seconds = timeLoop(n, [&](long long i) {
+            size_t k = i % positions.size();
+            rows += engines[k].dropDistance(positions[k].second);
+        });
+        benchSink = benchSink + rows;
+        return seconds;
+    }});
+
+    // A whole seeded game with random inputs, as the headless runner plays it
+    cases.push_back({"headlessGame", "macro", 2000, [](long long n) {
+        HeadlessOptions options;
+        HeadlessTotals totals;
+        TetrisEngine engine(0);
+        double seconds = timeLoop(n, [&](long long i) {
+            playHeadlessGame(engine, static_cast<uint32_t>(i), options, totals);
+        });
+        benchSink = benchSink + totals.pieces;
+        return seconds;
+    }});
+
+    return cases;
+}
+
+inline std::string benchmarksToJson(const std::vector<BenchmarkResult>& results) {
+    std::ostringstream out;
+    out << std::setprecision(6);
+    out << "{\n  \"suite\": \"tetris\",\n  \"unit\": \"ns/op\",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"kind\": \"" << r.kind << "\", \"iterations\": " << r.iterations
+            << ", \"value\": " << r.nsPerOp << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return out.str();
+}
+
+// Reads back the name/value pairs of a file written by benchmarksToJson
+inline bool readBenchmarkJson(const std::string& path, std::map<std::string, double>& values) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    static const std::regex entry(R"re("name"\s*:\s*"([^"]+)"[^}]*"value"\s*:\s*([-+0-9.eE]+))re");
+    for (std::sregex_iterator it(text.begin(), text.end(), entry), end; it != end; ++it) {
+        values[(*it)[1]] = std::atof((*it)[2].str().c_str());
+    }
+    return !values.empty();
+}
+
+// Prints each shared metric's change against the baseline; false if any got slower than threshold percent
+inline bool compareBenchmarks(const std::vector<BenchmarkResult>& results, const std::map<std::string, double>& baseline,
+                              double threshold) {
+    bool ok = true;
+    for (const BenchmarkResult& r : results) {
+        auto base = baseline.find(r.name);
+        if (base == baseline.end() || base->second <= 0) {
+            std::cerr << r.name << ": no baseline" << std::endl;
+            continue;
+        }
+        double change = (r.nsPerOp - base->second) / base->second * 100.0;
+        bool regressed = change > threshold;
+        ok &= !regressed;
+        std::cerr << r.name << ": " << base->second << " -> " << r.nsPerOp << " ns/op (" << std::showpos << change
+                  << std::noshowpos << "%)" << (regressed ? "  REGRESSION" : "") << std::endl;
+    }
+    return ok;
+}
+
+inline int runBenchmarkSuite(int argc, char** argv, std::vector<BenchmarkCase> cases) {
+    std::string filter, outPath, baselinePath;
+    int repetitions = 5;
+    double scale = 1.0, threshold = 10.0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue) filter = argv[++i];
+        else if (arg == "--repetitions" && hasValue) repetitions = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--scale" && hasValue) scale = std::max(0.0001, std::atof(argv[++i]));
+        else if (arg == "--out" && hasValue) outPath = argv[++i];
+        else if (arg == "--compare" && hasValue) baselinePath = argv[++i];
+        else if (arg == "--threshold" && hasValue) threshold = std::atof(argv[++i]);
+    }
+
+    std::vector<BenchmarkResult> results;
+    for (const BenchmarkCase& c : cases) {
+        if (!filter.empty() && c.name.find(filter) == std::string::npos) continue;
+        BenchmarkResult result{c.name, c.kind, std::max(1LL, static_cast<long long>(c.iterations * scale)), 0};
+        // One untimed warm-up run, then the median of the timed ones
+        c.run(std::max(1LL, result.iterations / 10));
+        std::vector<double> nsPerOp;
+        for (int r = 0; r < repetitions; ++r) {
+            nsPerOp.push_back(c.run(result.iterations) * 1e9 / result.iterations);
+        }
+        std::nth_element(nsPerOp.begin(), nsPerOp.begin() + nsPerOp.size() / 2, nsPerOp.end());
+        result.nsPerOp = nsPerOp[nsPerOp.size() / 2];
+        std::cerr << c.name << ": " << result.nsPerOp << " ns/op" << std::endl;
+        results.push_back(result);
+    }
+
+    std::string json = benchmarksToJson(results);
+    if (outPath.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream file(outPath, std::ios::trunc);
+        if (!(file << json)) {
+            std::cerr << "Failed to write " << outPath << std::endl;
+            return 1;
+        }
+    }
+
+    if (!baselinePath.empty()) {
+        std::map<std::string, double> baseline;
+        if (!readBenchmarkJson(baselinePath, baseline)) {
+            std::cerr << "Could not read baseline " << baselinePath << std::endl;
+            return 1;
+        }
+        if (!compareBenchmarks(results, baseline, threshold)) {
+            std::cerr << "Benchmarks regressed by more than " << threshold << "%" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -1,6 +1,12 @@
 #!/bin/bash
 
 # Compile the Tetris game and capture errors
-g++ -o tetris main.cpp -lsfml-graphics -lsfml-window -lsfml-audio -lsfml-system 2>&1 > compilererror.txt
+g++ -o tetris main.cpp -pthread -lsfml-graphics -lsfml-window -lsfml-audio -lsfml-system 2>&1 > compilererror.txt
+
+# Headless runner, builds without SFML for display-less machines
+g++ -O2 -DHEADLESS_ONLY -o tetris_headless main.cpp -pthread 2>&1 >> compilererror.txt
+
+# Benchmark suite: engine micro-benchmarks, a headless game and an offscreen draw() frame, as JSON
+g++ -O2 -DBENCHMARK_MAIN -o tetris_bench main.cpp -pthread -lsfml-graphics -lsfml-window -lsfml-audio -lsfml-system 2>&1 >> compilererror.txt
 
 echo "Compilation output saved to compilererror.txt"
@@ -0,0 +1,625 @@
+// Tetris game core with no SFML dependency
+// Shared by the windowed TetrisApp and the headless runner
+#pragma once
+
+#include <array>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <functional>
+#include <algorithm>
+#include <type_traits>
+#include "profiler.hpp"
+
+// Colours are packed RGBA, the same layout as sf::Color::toInteger()
+const uint32_t EMPTY_CELL = 0;
+
+// Narrowest unsigned type with a bit for every column
+template<int W>
+using RowMaskFor = std::conditional_t<(W <= 16), uint16_t, std::conditional_t<(W <= 32), uint32_t, uint64_t>>;
+
+// Row-bitmask board of W columns and H rows: bit x of row(y) is set when cell (x, y) is filled;
+// a row is full when its mask is FULL_ROW, so the mask doubles as the row's fill counter.
+// The masks sit in a ring of H slots starting at `base`, stored twice over so the H rows from any
+// base are contiguous: rowMasks() is a plain array to the collision check, and clearing lines can
+// rotate the ring instead of moving the stack. Colours live in a separate plane, only meaningful
+// for filled cells, whose rows are reached through each slot's plane index, so no clear ever
+// moves a colour. columnTops caches the surface; set(), clear() and clearFullRows() keep it
+// current, and setRows() is the only way to replace the occupancy wholesale.
+// Every size is its own type, so loops over rows and columns have compile-time bounds.
+template<int W, int H>
+class BasicBoard {
+public:
+    static_assert(W >= 4 && W <= 64, "a row is one machine word and must fit the I piece");
+    static_assert(H >= 4 && H <= 65536, "colour rows are indexed by uint16_t");
+
+    static constexpr int WIDTH = W;
+    static constexpr int HEIGHT = H;
+    using Mask = RowMaskFor<W>;
+    static constexpr Mask FULL_ROW = W == static_cast<int>(sizeof(Mask) * 8) ? static_cast<Mask>(~Mask(0))
+                                                                             : static_cast<Mask>((Mask(1) << (W % (sizeof(Mask) * 8))) - 1);
+    // Just the occupancy bits of a board, cheap to copy for searches
+    using Rows = std::array<Mask, H>;
+    using ColumnTops = std::array<int, W>;
+
+    // shapeRows[i] holds the piece cells of row i as bits, column 0 in bit 0.
+    // Returns true if the shape fits with its top-left corner at (x, y) on the H rows at `rows`.
+    static bool rowsFit(const Mask* rows, const uint32_t* shapeRows, int rowCount, int x, int y) {
+        for (int i = 0; i < rowCount; ++i) {
+            uint32_t bits = shapeRows[i];
+            if (!bits) continue;
+            Mask placed;
+            if (x < 0) {
+                if (bits & ((1u << -x) - 1)) return false; // past the left wall
+                placed = static_cast<Mask>(bits >> -x);
+            } else if constexpr (W <= 28) {
+                // Room in 32 bits for a shape hanging over the right wall
+                bits <<= x;
+                if (bits & ~static_cast<uint32_t>(FULL_ROW)) return false;
+                placed = static_cast<Mask>(bits);
+            } else {
+                // Shapes are at most 4 wide, so only the last 3 columns can push cells past the right wall
+                if (x >= W || (W - x < 4 && (bits >> (W - x)))) return false;
+                placed = static_cast<Mask>(static_cast<Mask>(bits) << x);
+            }
+            int row = y + i;
+            if (row >= H) return false;
+            if (row >= 0 && (rows[row] & placed)) return false;
+        }
+        return true;
+    }
+
+    // Removes full rows from a mask-only board; returns how many were removed
+    static int clearFullRowMasks(Rows& rows) {
+        int write = H - 1;
+        for (int y = H - 1; y >= 0; --y) {
+            if (rows[y] != FULL_ROW) rows[write--] = rows[y];
+        }
+        int removed = write + 1;
+        for (; write >= 0; --write) {
+            rows[write] = 0;
+        }
+        return removed;
+    }
+
+    // Row of the highest filled cell in each column, H for an empty column
+    static ColumnTops surfaceOf(const Mask* rows) {
+        ColumnTops tops;
+        tops.fill(H);
+        Mask seen = 0;
+        for (int y = 0; y < H && seen != FULL_ROW; ++y) {
+            Mask fresh = static_cast<Mask>(rows[y] & ~seen);
+            for (int x = 0; fresh; ++x, fresh >>= 1) {
+                if (fresh & 1u) tops[x] = y;
+            }
+            seen |= rows[y];
+        }
+        return tops;
+    }
+
+    std::array<uint32_t, W * H> colors{};
+    ColumnTops columnTops = emptySurface();
+
+    // Keeps board[y][x] working, reads EMPTY_CELL for empty cells
+    struct RowView {
+        const BasicBoard& board;
+        int y;
+        uint32_t operator[](int x) const { return board.cell(x, y); }
+    };
+    RowView operator[](int y) const { return RowView{*this, y}; }
+
+    Mask row(int y) const { return masks[base + y]; }
+
+    // The H row masks top to bottom, valid until the board next changes
+    const Mask* rowMasks() const { return masks.data() + base; }
+
+    // A copy of the occupancy, for searches that play on their own boards
+    Rows occupancy() const {
+        Rows rows;
+        std::copy_n(rowMasks(), H, rows.begin());
+        return rows;
+    }
+
+    bool filled(int x, int y) const { return (row(y) >> x) & 1u; }
+
+    uint32_t cell(int x, int y) const {
+        return filled(x, y) ? colors[planeRows[base + y] * W + x] : EMPTY_CELL;
+    }
+
+    void set(int x, int y, uint32_t color) {
+        writeRow(y, static_cast<Mask>(row(y) | (Mask(1) << x)), planeRows[base + y]);
+        colors[planeRows[base + y] * W + x] = color;
+        columnTops[x] = std::min(columnTops[x], y);
+    }
+
+    void clear() {
+        masks.fill(0);
+        columnTops.fill(H);
+    }
+
+    // Replaces the occupancy (colours are left as they are) and rebuilds the surface
+    void setRows(const Rows& newRows) {
+        for (int y = 0; y < H; ++y) {
+            writeRow(y, newRows[y], planeRows[base + y]);
+        }
+        columnTops = surfaceOf(rowMasks());
+    }
+
+    // See rowsFit
+    bool fits(const uint32_t* shapeRows, int rowCount, int x, int y) const {
+        return rowsFit(rowMasks(), shapeRows, rowCount, x, y);
+    }
+
+    // Drops the full rows among rows from..to (every row by default) and shifts the rows above
+    // down; returns how many were removed. Only masks and plane indices move, never colours,
+    // and only on one side of the cleared rows: either the stack between its top and the lowest
+    // cleared row moves down, or the ring turns by the number of cleared rows and the rows below
+    // the highest cleared row move up to close the gap, whichever moves fewer rows. Clears at the
+    // bottom of a tall stack, the common case, cost the cleared rows plus the rows under them.
+    int clearFullRows(int from = 0, int to = H - 1) {
+        from = std::max(from, 0);
+        to = std::min(to, H - 1);
+        std::array<uint16_t, H> cleared; // full rows, lowest first
+        int removed = 0;
+        for (int y = to; y >= from; --y) {
+            if (row(y) == FULL_ROW) cleared[removed++] = static_cast<uint16_t>(y);
+        }
+        if (!removed) {
+            return 0;
+        }
+        int stackTop = *std::min_element(columnTops.begin(), columnTops.end());
+        std::array<uint16_t, H> freed;
+        for (int i = 0; i < removed; ++i) {
+            freed[i] = planeRows[base + cleared[i]];
+        }
+        int highest = cleared[removed - 1];
+        int rowsAbove = cleared[0] + 1 - stackTop - removed;
+        int rowsBelow = H - highest - removed;
+        if (rowsAbove <= rowsBelow) {
+            // Each run of rows between two cleared rows drops by the number cleared below it
+            for (int i = 0; i < removed; ++i) {
+                int first = i + 1 < removed ? cleared[i + 1] + 1 : stackTop;
+                moveRows(first, cleared[i] - 1, first + i + 1);
+            }
+            for (int i = 0; i < removed; ++i) {
+                writeRow(stackTop + i, 0, freed[i]);
+            }
+        } else {
+            // Each run of rows below the highest cleared row rises by the number cleared above it,
+            // then the ring turns so everything drops by `removed`, and the freed slots at the
+            // bottom come round as the empty rows on top
+            for (int i = removed - 1; i >= 0; --i) {
+                int last = i > 0 ? cleared[i - 1] - 1 : H - 1;
+                moveRows(cleared[i] + 1, last, cleared[i] + 1 - (removed - i));
+            }
+            for (int i = 0; i < removed; ++i) {
+                writeRow(H - removed + i, 0, freed[i]);
+            }
+            base = (base + H - removed) % H;
+        }
+        updateColumnTops(cleared, removed);
+        return removed;
+    }
+
+private:
+    // Slot s and s + H hold the same row, and row y is at base + y, somewhere in 0..2H-1
+    std::array<Mask, 2 * H> masks{};
+    std::array<uint16_t, 2 * H> planeRows = identityPlaneRows(); // colour-plane row of each slot
+    int base = 0;
+
+    static std::array<uint16_t, 2 * H> identityPlaneRows() {
+        std::array<uint16_t, 2 * H> map;
+        for (int s = 0; s < 2 * H; ++s) map[s] = static_cast<uint16_t>(s % H);
+        return map;
+    }
+
+    static ColumnTops emptySurface() {
+        ColumnTops tops;
+        tops.fill(H);
+        return tops;
+    }
+
+    // Writes row y into both copies of its slot
+    void writeRow(int y, Mask mask, uint16_t plane) {
+        int slot = base + y;
+        int twin = slot < H ? slot + H : slot - H;
+        masks[slot] = masks[twin] = mask;
+        planeRows[slot] = planeRows[twin] = plane;
+    }
+
+    // Moves rows first..last to start at row `to`: block moves in the contiguous view, then the
+    // slots written are copied to their twins
+    void moveRows(int first, int last, int to) {
+        if (first > last) return;
+        Mask* rows = masks.data() + base;
+        uint16_t* planes = planeRows.data() + base;
+        if (to > first) {
+            std::copy_backward(rows + first, rows + last + 1, rows + to + last - first + 1);
+            std::copy_backward(planes + first, planes + last + 1, planes + to + last - first + 1);
+        } else {
+            std::copy(rows + first, rows + last + 1, rows + to);
+            std::copy(planes + first, planes + last + 1, planes + to);
+        }
+        int begin = base + to, end = base + to + last - first + 1; // slots written
+        if (begin < H) {
+            int split = std::min(end, H);
+            std::copy(masks.begin() + begin, masks.begin() + split, masks.begin() + begin + H);
+            std::copy(planeRows.begin() + begin, planeRows.begin() + split, planeRows.begin() + begin + H);
+        }
+        if (end > H) {
+            int from = std::max(begin, H);
+            std::copy(masks.begin() + from, masks.begin() + end, masks.begin() + from - H);
+            std::copy(planeRows.begin() + from, planeRows.begin() + end, planeRows.begin() + from - H);
+        }
+    }
+
+    // A surviving top cell moves down by the cleared rows below it, which is all of them for a top
+    // above the highest. A column whose top cell was in a cleared row is scanned down from there;
+    // rows above it hold nothing in that column.
+    void updateColumnTops(const std::array<uint16_t, H>& cleared, int removed) {
+        int highest = cleared[removed - 1];
+        for (int x = 0; x < W; ++x) {
+            int top = columnTops[x];
+            if (top < highest) {
+                columnTops[x] = top + removed;
+                continue;
+            }
+            if (top == H) continue;
+            int below = 0;
+            bool topCleared = false;
+            for (int i = 0; i < removed; ++i) {
+                below += cleared[i] > top;
+                topCleared |= cleared[i] == top;
+            }
+            if (!topCleared) {
+                columnTops[x] = top + below;
+                continue;
+            }
+            while (top < H && !filled(x, top)) ++top;
+            columnTops[x] = top;
+        }
+    }
+};
+
+// The classic 10x20 board. Everything outside the engine (the automatic player, move generator,
+// feature extraction, solver and the on-disk formats) works on this size only.
+const int BOARD_WIDTH = 10;
+const int BOARD_HEIGHT = 20;
+
+using Board = BasicBoard<BOARD_WIDTH, BOARD_HEIGHT>;
+using RowMask = Board::Mask;
+const RowMask FULL_ROW = Board::FULL_ROW;
+using BoardRows = Board::Rows;
+using ColumnTops = Board::ColumnTops;
+
+inline bool rowsFit(const BoardRows& rows, const uint32_t* shapeRows, int rowCount, int x, int y) {
+    return Board::rowsFit(rows.data(), shapeRows, rowCount, x, y);
+}
+
+inline int clearFullRowMasks(BoardRows& rows) {
+    return Board::clearFullRowMasks(rows);
+}
+
+inline ColumnTops surfaceOf(const BoardRows& rows) {
+    return Board::surfaceOf(rows.data());
+}
+
+using ShapeMatrix = std::vector<std::vector<int>>;
+
+struct Cell {
+    int x, y;
+};
+
+struct Piece {
+    char shape;
+    int rotation;
+    uint32_t color;
+    int x, y;
+};
+
+// One orientation of a shape: its bounding box, the filled cells of each row as bits
+// (column 0 in bit 0), the same cells as offsets from the top-left corner and the
+// lowest filled row of each column
+struct ShapeRotation {
+    int width;
+    int height;
+    uint32_t rows[4];
+    Cell cells[4];
+    int bottoms[4]{}; // lowest filled row per column, filled in by withCells
+};
+
+const int SHAPE_COUNT = 7;
+constexpr char SHAPE_NAMES[SHAPE_COUNT] = {'I', 'J', 'L', 'O', 'S', 'T', 'Z'};
+
+// Spawn orientations, drawn with column 0 on the left:
+//   I ####   J #..   L ..#   O ##   S .##   T .#.   Z ##.
+//            ###     ###     ##     ##.     ###     .##
+constexpr ShapeRotation BASE_SHAPES[SHAPE_COUNT] = {
+    {4, 1, {0b1111}, {}},
+    {3, 2, {0b001, 0b111}, {}},
+    {3, 2, {0b100, 0b111}, {}},
+    {2, 2, {0b11, 0b11}, {}},
+    {3, 2, {0b110, 0b011}, {}},
+    {3, 2, {0b010, 0b111}, {}},
+    {3, 2, {0b011, 0b110}, {}}
+};
+
+const std::array<uint32_t, SHAPE_COUNT> PIECE_COLORS = {
+    0x00FFFFFF, // I: Cyan
+    0x0000FFFF, // J: Blue
+    0xFFA500FF, // L: Orange
+    0xFFFF00FF, // O: Yellow
+    0x00FF00FF, // S: Green
+    0x800080FF, // T: Purple
+    0xFF0000FF  // Z: Red
+};
+
+constexpr int shapeIndex(char shape) {
+    switch (shape) {
+        case 'I': return 0;
+        case 'J': return 1;
+        case 'L': return 2;
+        case 'O': return 3;
+        case 'S': return 4;
+        case 'T': return 5;
+        default:  return 6; // 'Z'
+    }
+}
+
+constexpr ShapeRotation withCells(ShapeRotation r) {
+    int count = 0;
+    for (int y = 0; y < r.height; ++y)
+        for (int x = 0; x < r.width; ++x)
+            if ((r.rows[y] >> x) & 1u) {
+                r.cells[count++] = Cell{x, y};
+                r.bottoms[x] = y;
+            }
+    return r;
+}
+
+// Same clockwise turn as rotateShape: cell (x, y) moves to (height - 1 - y, x)
+constexpr ShapeRotation rotateClockwise(const ShapeRotation& r) {
+    ShapeRotation out{r.height, r.width, {}, {}, {}};
+    for (int y = 0; y < r.height; ++y)
+        for (int x = 0; x < r.width; ++x)
+            if ((r.rows[y] >> x) & 1u) out.rows[x] |= 1u << (r.height - 1 - y);
+    return withCells(out);
+}
+
+constexpr std::array<std::array<ShapeRotation, 4>, SHAPE_COUNT> buildRotations() {
+    std::array<std::array<ShapeRotation, 4>, SHAPE_COUNT> table{};
+    for (int s = 0; s < SHAPE_COUNT; ++s) {
+        table[s][0] = withCells(BASE_SHAPES[s]);
+        for (int rot = 1; rot < 4; ++rot) {
+            table[s][rot] = rotateClockwise(table[s][rot - 1]);
+        }
+    }
+    return table;
+}
+
+// ROTATIONS[shapeIndex(shape)][rotation], computed at compile time
+constexpr std::array<std::array<ShapeRotation, 4>, SHAPE_COUNT> ROTATIONS = buildRotations();
+
+static_assert(ROTATIONS[0][1].width == 1 && ROTATIONS[0][1].height == 4, "I turns vertical");
+static_assert(ROTATIONS[1][1].rows[0] == 0b11 && ROTATIONS[1][1].rows[2] == 0b01, "J turns clockwise");
+static_assert(ROTATIONS[5][2].bottoms[1] == 1 && ROTATIONS[5][2].bottoms[0] == 0, "T points down");
+
+inline const ShapeRotation& shapeRotation(char shape, int rotation) {
+    return ROTATIONS[shapeIndex(shape)][rotation];
+}
+
+// Player inputs, matching the keys TetrisApp handles during a game
+enum class Input {
+    None,
+    Left,     // Left arrow
+    Right,    // Right arrow
+    Rotate,   // Up arrow
+    SoftDrop, // Down arrow
+    HardDrop  // S
+};
+
+// Game rules on a W x H board; TetrisEngine is the classic 10x20 one
+template<int W, int H>
+class BasicEngine {
+public:
+    static constexpr int WIDTH = W;
+    static constexpr int HEIGHT = H;
+    using BoardType = BasicBoard<W, H>;
+
+    BoardType board;
+    Piece currentPiece;
+    Piece nextPiece;
+    int score = 0;
+    int level = 1;
+    int linesCleared = 0;
+    int blocksPlaced = 0;
+    int fallSpeed = 500; // milliseconds
+    int tickRate = 60;      // simulation ticks per second, converts fallSpeed into ticks
+    int gravityCounter = 0; // ticks since the last gravity step
+    bool gameOver = false;
+    uint32_t boardRevision = 0; // bumped whenever board changes, so renderers can cache it
+    int ghostY = 0; // where currentPiece would land; updated when it moves sideways, rotates or spawns
+
+    // Called for every freshly spawned piece, e.g. to recolour it for rainbow mode
+    std::function<void(Piece&)> onNewPiece;
+
+    explicit BasicEngine(uint32_t seed = std::random_device{}())
+        : rng(seed) {
+        reset();
+    }
+
+    void reset() {
+        board.clear();
+        boardRevision++;
+        score = 0;
+        level = 1;
+        linesCleared = 0;
+        fallSpeed = 500;
+        blocksPlaced = 0;
+        gravityCounter = 0;
+        gameOver = false;
+        currentPiece = getNewPiece();
+        nextPiece = getNewPiece();
+        updateGhost();
+    }
+
+    void reset(uint32_t seed) {
+        rng.seed(seed);
+        reset();
+    }
+
+    Piece getNewPiece() {
+        std::uniform_int_distribution<int> dist(0, SHAPE_COUNT - 1);
+        int idx = dist(rng);
+        Piece piece{SHAPE_NAMES[idx], 0, PIECE_COLORS[idx], W / 2 - 2, 0};
+        if (onNewPiece) {
+            onNewPiece(piece);
+        }
+        return piece;
+    }
+
+    ShapeMatrix rotateShape(const ShapeMatrix& matrix) const {
+        int n = matrix.size();
+        int m = matrix[0].size();
+        ShapeMatrix rotated(m, std::vector<int>(n, 0));
+        for (int i = 0; i < n; ++i)
+            for (int j = 0; j < m; ++j)
+                rotated[j][n - i - 1] = matrix[i][j];
+        return rotated;
+    }
+
+    // Allocates; hot paths use shapeRotation() instead
+    ShapeMatrix getShapeMatrix(const Piece& piece) const {
+        const ShapeRotation& r = shapeRotation(piece.shape, piece.rotation);
+        ShapeMatrix matrix(r.height, std::vector<int>(r.width, 0));
+        for (const Cell& c : r.cells) {
+            matrix[c.y][c.x] = 1;
+        }
+        return matrix;
+    }
+
+    bool validPosition(const Piece& piece, int adjX = 0, int adjY = 0, int rotation = -1) const {
+        int rot = (rotation == -1) ? piece.rotation : rotation;
+        const ShapeRotation& r = shapeRotation(piece.shape, rot);
+        return board.fits(r.rows, r.height, piece.x + adjX, piece.y + adjY);
+    }
+
+    // Rows the piece can fall before it lands. Read off the column surface when the piece is
+    // above it in every column it covers; a piece tucked under an overhang falls back to a scan.
+    int dropDistance(const Piece& piece) const {
+        const ShapeRotation& r = shapeRotation(piece.shape, piece.rotation);
+        int distance = H;
+        for (int c = 0; c < r.width; ++c) {
+            int bottom = piece.y + r.bottoms[c];
+            int top = board.columnTops[piece.x + c];
+            if (bottom >= top) {
+                int fall = 0;
+                while (validPosition(piece, 0, fall + 1)) ++fall;
+                return fall;
+            }
+            distance = std::min(distance, top - bottom - 1);
+        }
+        return distance;
+    }
+
+    // Locks the current piece, clears lines and spawns the next piece
+    void placePiece() {
+        ProfileScope scope("placePiece");
+        const ShapeRotation& r = shapeRotation(currentPiece.shape, currentPiece.rotation);
+        for (const Cell& c : r.cells) {
+            int boardX = currentPiece.x + c.x;
+            int boardY = currentPiece.y + c.y;
+            if (boardY >= 0 && boardY < H && boardX >= 0 && boardX < W) {
+                board.set(boardX, boardY, currentPiece.color);
+            }
+        }
+        gravityCounter = 0; // the next piece gets a full gravity interval
+        score += 1; // +1 point for each block placed
+        clearLines(currentPiece.y, currentPiece.y + r.height - 1); // only rows the piece touched can have filled up
+        boardRevision++;
+        blocksPlaced++;
+        currentPiece = nextPiece;
+        nextPiece = getNewPiece();
+        if (!validPosition(currentPiece)) {
+            gameOver = true;
+        }
+        updateGhost();
+    }
+
+    // Clears full rows among rows from..to, every row by default
+    void clearLines(int from = 0, int to = H - 1) {
+        ProfileScope scope("clearLines");
+        int removed = board.clearFullRows(from, to);
+        for (int i = 0; i < removed; ++i) {
+            ++linesCleared;
+            score += 100 * level;
+            level = linesCleared / 10 + 1;
+            fallSpeed = std::max(100, 500 - (level - 1) * 50);
+        }
+    }
+
+    bool tryMove(int dx, int dy) {
+        if (validPosition(currentPiece, dx, dy)) {
+            currentPiece.x += dx;
+            currentPiece.y += dy;
+            if (dx) updateGhost(); // falling straight down doesn't change where it lands
+            return true;
+        }
+        return false;
+    }
+
+    bool tryRotate() {
+        int newRotation = (currentPiece.rotation + 1) % 4;
+        if (validPosition(currentPiece, 0, 0, newRotation)) {
+            currentPiece.rotation = newRotation;
+            updateGhost();
+            return true;
+        }
+        return false;
+    }
+
+    void hardDrop() {
+        currentPiece.y += dropDistance(currentPiece);
+        placePiece();
+    }
+
+    // One gravity step; returns true if the piece locked
+    bool stepDown() {
+        if (tryMove(0, 1)) {
+            return false;
+        }
+        placePiece();
+        return true;
+    }
+
+    // Advances one fixed simulation tick; returns true if gravity locked the piece
+    bool tick() {
+        if (gameOver) return false;
+        if (++gravityCounter * 1000 < fallSpeed * tickRate) return false;
+        gravityCounter = 0;
+        return stepDown();
+    }
+
+    // Applies a player input; returns true if it locked the piece
+    bool apply(Input input) {
+        if (gameOver) return false;
+        switch (input) {
+            case Input::Left:     tryMove(-1, 0); break;
+            case Input::Right:    tryMove(1, 0); break;
+            case Input::Rotate:   tryRotate(); break;
+            case Input::SoftDrop: tryMove(0, 1); break;
+            case Input::HardDrop: hardDrop(); return true;
+            case Input::None:     break;
+        }
+        return false;
+    }
+
+private:
+    std::mt19937 rng;
+
+    void updateGhost() {
+        ghostY = currentPiece.y + dropDistance(currentPiece);
+    }
+};
+
+using TetrisEngine = BasicEngine<BOARD_WIDTH, BOARD_HEIGHT>;
@@ -0,0 +1,123 @@
+// Board features for bots and analytics, computed from the row masks in one sweep.
+// Boards are processed in batches laid out lane-per-board, so every inner loop runs
+// across the batch with plain integer ops and the compiler turns it into SIMD.
+#pragma once
+
+#include "engine.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+
+struct BoardFeatureSet {
+    int heights[BOARD_WIDTH] = {};
+    int aggregateHeight = 0;
+    int maxHeight = 0;
+    int holes = 0;          // empty cells with a filled cell somewhere above
+    int bumpiness = 0;      // sum of height differences between neighbouring columns
+    int wellDepths = 0;     // sum over columns of how far each sits below both neighbours (walls count as full)
+    int maxWellDepth = 0;
+    int rowTransitions = 0; // filled/empty changes along each row up to the stack top, walls count as filled
+};
+
+const int FEATURE_BATCH = 16;
+
+// Bits set in a value below 2^16, without a popcount instruction so it vectorizes on SSE2
+inline uint32_t popcount16(uint32_t v) {
+    v = v - ((v >> 1) & 0x5555u);
+    v = (v & 0x3333u) + ((v >> 2) & 0x3333u);
+    v = (v + (v >> 4)) & 0x0F0Fu;
+    return (v + (v >> 8)) & 0x1Fu;
+}
+
+// Features of up to FEATURE_BATCH boards; the fixed lane count lets GCC vectorize at -O2
+inline void extractFeatureBatch(const BoardRows* boards, int count, BoardFeatureSet* out) {
+    const int B = FEATURE_BATCH;
+    uint32_t rows[BOARD_HEIGHT][B] = {};
+    for (int b = 0; b < count; ++b) {
+        for (int y = 0; y < BOARD_HEIGHT; ++y) {
+            rows[y][b] = boards[b][y];
+        }
+    }
+
+    // heights[x + 1] is column x; the two extra columns are the walls, as tall as the board
+    uint32_t seen[B] = {};
+    int32_t heights[BOARD_WIDTH + 2][B] = {};
+    uint32_t holes[B] = {};
+    uint32_t transitions[B] = {};
+    const uint32_t PAIRS = (1u << (BOARD_WIDTH + 1)) - 1;
+    for (int y = 0; y < BOARD_HEIGHT; ++y) {
+        for (int b = 0; b < B; ++b) {
+            uint32_t row = rows[y][b];
+            seen[b] |= row;
+            holes[b] += popcount16(seen[b] & ~row);
+            // Walls on both sides as filled cells, then count neighbouring pairs that differ
+            uint32_t walled = (row << 1) | 1u | (1u << (BOARD_WIDTH + 1));
+            uint32_t changes = popcount16((walled ^ (walled >> 1)) & PAIRS);
+            transitions[b] += changes * (seen[b] != 0); // rows above the stack don't count
+        }
+    }
+    // A column's height is the number of rows at or below its topmost block
+    for (int b = 0; b < B; ++b) {
+        seen[b] = 0;
+    }
+    for (int y = 0; y < BOARD_HEIGHT; ++y) {
+        for (int b = 0; b < B; ++b) {
+            seen[b] |= rows[y][b];
+        }
+        for (int x = 0; x < BOARD_WIDTH; ++x) {
+            for (int b = 0; b < B; ++b) {
+                heights[x + 1][b] += static_cast<int32_t>((seen[b] >> x) & 1u);
+            }
+        }
+    }
+    for (int b = 0; b < B; ++b) {
+        heights[0][b] = BOARD_HEIGHT;
+        heights[BOARD_WIDTH + 1][b] = BOARD_HEIGHT;
+    }
+
+    int32_t aggregate[B] = {}, maxHeight[B] = {}, bumpiness[B] = {}, wells[B] = {}, maxWell[B] = {};
+    for (int x = 1; x <= BOARD_WIDTH; ++x) {
+        for (int b = 0; b < B; ++b) {
+            int32_t h = heights[x][b];
+            int32_t well = std::max(0, std::min(heights[x - 1][b], heights[x + 1][b]) - h);
+            aggregate[b] += h;
+            maxHeight[b] = std::max(maxHeight[b], h);
+            wells[b] += well;
+            maxWell[b] = std::max(maxWell[b], well);
+        }
+    }
+    for (int x = 2; x <= BOARD_WIDTH; ++x) {
+        for (int b = 0; b < B; ++b) {
+            bumpiness[b] += std::abs(heights[x][b] - heights[x - 1][b]);
+        }
+    }
+
+    for (int b = 0; b < count; ++b) {
+        BoardFeatureSet& f = out[b];
+        for (int x = 0; x < BOARD_WIDTH; ++x) {
+            f.heights[x] = heights[x + 1][b];
+        }
+        f.aggregateHeight = aggregate[b];
+        f.maxHeight = maxHeight[b];
+        f.holes = static_cast<int>(holes[b]);
+        f.bumpiness = bumpiness[b];
+        f.wellDepths = wells[b];
+        f.maxWellDepth = maxWell[b];
+        f.rowTransitions = static_cast<int>(transitions[b]);
+    }
+}
+
+// Any number of boards, FEATURE_BATCH at a time
+inline void extractFeatures(const BoardRows* boards, size_t count, BoardFeatureSet* out) {
+    for (size_t i = 0; i < count; i += FEATURE_BATCH) {
+        int n = static_cast<int>(std::min<size_t>(FEATURE_BATCH, count - i));
+        extractFeatureBatch(boards + i, n, out + i);
+    }
+}
+
+inline BoardFeatureSet extractFeatures(const BoardRows& board) {
+    BoardFeatureSet features;
+    extractFeatureBatch(&board, 1, &features);
+    return features;
+}
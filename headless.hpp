@@ -0,0 +1,258 @@
+// Headless batch runner: plays seeded games on the engine without a window
+// Usage: tetris --headless [--games N] [--seed S] [--threads T] [--max-pieces P]
+//                          [--gravity-every F] [--script LRUDS.]
+//        tetris --headless --bench-board [--iterations N]
+//        tetris --headless --bench-synth [--iterations N]
+//        tetris --headless --bench-movegen [--iterations N]
+//        tetris --headless --bench-features [--iterations N]
+//        tetris --headless --record-dir DIR [game options]   (tick-driven games, one replay file each)
+//        tetris --headless --replay FILE [--realtime] [--seek TICK] [--repeat N]
+//        tetris --headless --verify-replays DIR [--threads T]
+//        tetris --headless --bot [--bot-threads B] [--bot-weights CHECKPOINT] [game options]   (the automatic player instead of random inputs)
+//        tetris --headless --tune [tuner options]   (see tuner.hpp)
+//        tetris --headless --solve [solver options]   (see solver.hpp)
+//        tetris --headless --alloc-check [--frames N] [--warmup N] [--seed S]   (see alloccheck.hpp)
+//        tetris --headless --stress [--size WxH] [--iterations N] [--games N]   (see stress.hpp)
+//        tetris --headless --save-self-test   (legacy save migration, see savegame.hpp)
+#pragma once
+
+#include "engine.hpp"
+#include "bench.hpp"
+#include "replay.hpp"
+#include "verify.hpp"
+#include "ai.hpp"
+#include "tuner.hpp"
+#include "solver.hpp"
+#include "alloccheck.hpp"
+#include "stress.hpp"
+#include "savegame.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+
+struct HeadlessOptions {
+    long long games = 1000;
+    uint32_t seed = 1;
+    int threads = 1;
+    int maxPieces = 10000;   // safety cap so scripted games always end
+    int gravityEvery = 4;    // inputs between gravity steps
+    std::string script;      // empty means random inputs
+    std::string recordDir;   // when set, games run on ticks like the app and are saved as replays
+    bool bot = false;        // play with the automatic player
+    int botThreads = 1;      // search threads per game thread, 0 for one per core
+    std::string botWeights;  // tuner checkpoint whose best weights the bot plays with
+};
+
+struct HeadlessTotals {
+    long long games = 0;
+    long long pieces = 0;
+    long long lines = 0;
+    long long score = 0;
+    long long nodes = 0; // boards the bot evaluated
+};
+
+// Script characters use the same letters as the game keys: L, R, U (rotate), D, S, and '.' for no input
+inline Input scriptInput(char c) {
+    switch (c) {
+        case 'L': return Input::Left;
+        case 'R': return Input::Right;
+        case 'U': return Input::Rotate;
+        case 'D': return Input::SoftDrop;
+        case 'S': return Input::HardDrop;
+        default:  return Input::None;
+    }
+}
+
+// Random inputs from a seed-derived generator, or the script on a loop
+class HeadlessInputs {
+public:
+    HeadlessInputs(uint32_t seed, const std::string& inputScript)
+        : inputRng(seed ^ 0x9E3779B9u), inputDist(0, 5), script(inputScript) {}
+
+    Input next() {
+        if (script.empty()) {
+            return static_cast<Input>(inputDist(inputRng));
+        }
+        Input input = scriptInput(script[scriptPos]);
+        scriptPos = (scriptPos + 1) % script.size();
+        return input;
+    }
+
+private:
+    std::mt19937 inputRng;
+    std::uniform_int_distribution<int> inputDist;
+    const std::string& script;
+    size_t scriptPos = 0;
+};
+
+inline void addTotals(const TetrisEngine& engine, HeadlessTotals& totals) {
+    totals.games++;
+    totals.pieces += engine.blocksPlaced;
+    totals.lines += engine.linesCleared;
+    totals.score += engine.score;
+}
+
+inline void playHeadlessGame(TetrisEngine& engine, uint32_t seed, const HeadlessOptions& options, HeadlessTotals& totals) {
+    engine.reset(seed);
+    HeadlessInputs inputs(seed, options.script);
+    int frame = 0;
+
+    while (!engine.gameOver && engine.blocksPlaced < options.maxPieces) {
+        bool locked = engine.apply(inputs.next());
+        if (!locked && !engine.gameOver && ++frame % options.gravityEvery == 0) {
+            engine.stepDown();
+        }
+    }
+    addTotals(engine, totals);
+}
+
+inline void playBotGame(TetrisEngine& engine, uint32_t seed, const HeadlessOptions& options, HeadlessTotals& totals, PlacementSearch& search) {
+    engine.reset(seed);
+    long long nodesBefore = search.nodes();
+    playBotPieces(engine, search, options.maxPieces);
+    addTotals(engine, totals);
+    totals.nodes += search.nodes() - nodesBefore;
+}
+
+// Plays one input per tick in Simulation::step order and writes the game to recordDir
+inline void playRecordedGame(TetrisEngine& engine, uint32_t seed, const HeadlessOptions& options, HeadlessTotals& totals) {
+    engine.reset(seed);
+    HeadlessInputs inputs(seed, options.script);
+    ReplayRecorder recorder;
+    recorder.start(seed, engine.tickRate);
+
+    while (!engine.gameOver && engine.blocksPlaced < options.maxPieces) {
+        Input input = inputs.next();
+        engine.apply(input);
+        recorder.input(input);
+        engine.tick();
+        recorder.endTick();
+    }
+    addTotals(engine, totals);
+
+    std::string path = options.recordDir + "/game-" + std::to_string(seed) + REPLAY_EXTENSION;
+    if (!writeReplayFile(path, recorder.finish(engine))) {
+        std::cerr << "Failed to write replay " << path << std::endl;
+    }
+}
+
+inline HeadlessOptions parseHeadlessOptions(int argc, char** argv) {
+    HeadlessOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--games" && hasValue) options.games = std::atoll(argv[++i]);
+        else if (arg == "--seed" && hasValue) options.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--threads" && hasValue) options.threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--max-pieces" && hasValue) options.maxPieces = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--gravity-every" && hasValue) options.gravityEvery = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--script" && hasValue) options.script = argv[++i];
+        else if (arg == "--record-dir" && hasValue) options.recordDir = argv[++i];
+        else if (arg == "--bot") options.bot = true;
+        else if (arg == "--bot-threads" && hasValue) options.botThreads = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--bot-weights" && hasValue) options.botWeights = argv[++i];
+    }
+    return options;
+}
+
+inline int runHeadless(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--bench-board") {
+            return runBoardBenchmark(argc, argv);
+        }
+        if (std::string(argv[i]) == "--bench-synth") {
+            return runSynthBenchmark(argc, argv);
+        }
+        if (std::string(argv[i]) == "--bench-movegen") {
+            return runMoveGenBenchmark(argc, argv);
+        }
+        if (std::string(argv[i]) == "--bench-features") {
+            return runFeatureBenchmark(argc, argv);
+        }
+        if (std::string(argv[i]) == "--replay") {
+            return runReplay(argc, argv);
+        }
+        if (std::string(argv[i]) == "--verify-replays") {
+            return runReplayVerifier(argc, argv);
+        }
+        if (std::string(argv[i]) == "--tune") {
+            return runTuner(argc, argv);
+        }
+        if (std::string(argv[i]) == "--solve") {
+            return runSolver(argc, argv);
+        }
+        if (std::string(argv[i]) == "--alloc-check") {
+            return runSimulationAllocationCheck(argc, argv);
+        }
+        if (std::string(argv[i]) == "--stress") {
+            return runStress(argc, argv);
+        }
+        if (std::string(argv[i]) == "--save-self-test") {
+            return runSaveSelfTest();
+        }
+    }
+
+    HeadlessOptions options = parseHeadlessOptions(argc, argv);
+    BotWeights weights;
+    if (!options.botWeights.empty()) {
+        TunerState tuned;
+        if (!readTunerCheckpoint(options.botWeights, tuned)) {
+            std::cerr << "Could not read tuner checkpoint " << options.botWeights << std::endl;
+            return 1;
+        }
+        weights = toBotWeights(tuned.best);
+    }
+
+    // Game i always uses seed + i, so totals don't depend on the thread count
+    std::vector<HeadlessTotals> perThread(options.threads);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < options.threads; ++t) {
+        workers.emplace_back([&, t]() {
+            TetrisEngine engine(options.seed);
+            std::unique_ptr<PlacementSearch> search;
+            if (options.bot) {
+                search = std::make_unique<PlacementSearch>(options.botThreads, weights);
+            }
+            for (long long game = t; game < options.games; game += options.threads) {
+                uint32_t seed = options.seed + static_cast<uint32_t>(game);
+                if (search) {
+                    playBotGame(engine, seed, options, perThread[t], *search);
+                } else if (options.recordDir.empty()) {
+                    playHeadlessGame(engine, seed, options, perThread[t]);
+                } else {
+                    playRecordedGame(engine, seed, options, perThread[t]);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    HeadlessTotals totals;
+    for (const auto& t : perThread) {
+        totals.games += t.games;
+        totals.pieces += t.pieces;
+        totals.lines += t.lines;
+        totals.score += t.score;
+        totals.nodes += t.nodes;
+    }
+
+    std::cout << "games: " << totals.games << "\n"
+              << "pieces: " << totals.pieces << "\n"
+              << "lines: " << totals.lines << "\n"
+              << "score: " << totals.score << "\n"
+              << "seconds: " << seconds << "\n"
+              << "games/sec: " << (seconds > 0 ? totals.games / seconds : 0) << "\n"
+              << "pieces/sec: " << (seconds > 0 ? totals.pieces / seconds : 0) << std::endl;
+    if (options.bot) {
+        std::cout << "nodes: " << totals.nodes << "\n"
+                  << "nodes/sec: " << (seconds > 0 ? totals.nodes / seconds : 0) << std::endl;
+    }
+    return 0;
+}
@@ -6,6 +6,19 @@ int main() {
     std::cout << "Hello, World!" << std::endl;
     return 0;
 }
+#elif defined(HEADLESS_ONLY)
+// Display-less build of the headless runner, no SFML needed
+#include "headless.hpp"
+#include "benchsuite.hpp"
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--bench-suite") {
+            return runBenchmarkSuite(argc, argv, engineBenchmarks());
+        }
+    }
+    return runHeadless(argc, argv);
+}
 #else
 // Tetris game code
 #define _USE_MATH_DEFINES
@@ -25,6 +38,26 @@ int main() {
 #include <string>
 #include <functional>
 #include <optional>
+#include <atomic>
+#include <memory>
+#include <future>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <type_traits>
+#include "allocations.hpp"
+#include "engine.hpp"
+#include "profiler.hpp"
+#include "headless.hpp"
+#include "benchsuite.hpp"
+#include "renderer.hpp"
+#include "ui.hpp"
+#include "simulation.hpp"
+#include "metrics.hpp"
+#include "music.hpp"
+#include "startup.hpp"
+#include "savegame.hpp"
+#include "ai.hpp"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -36,6 +69,7 @@ template<class... Ts> struct overloaded : Ts... { using Ts::operator()...; };
 template<class... Ts> overloaded(Ts...) -> overloaded<Ts...>;
 
 enum class GameState {
+    Loading,
     MainMenu,
     Options,
     ModMenu,
@@ -50,7 +84,17 @@ struct Button {
     sf::Text text;
     std::function<void()> action;
 
+    // Optional live value shown as the button text, e.g. a toggle state
+    std::function<int()> boundValue;
+    ValueLabel label;
+
     Button(const sf::Font& font) : text(font, "") {}
+
+    void refresh() {
+        if (boundValue) {
+            label.update(text, boundValue());
+        }
+    }
 };
 
 struct Slider {
@@ -61,15 +105,21 @@ struct Slider {
     float minValue;
     float maxValue;
     bool isDragging = false;
+    ValueLabel valueLabel; // "<name>: <percent>%"
 
-    Slider(const sf::Font& font, const std::string& labelText, float* val, float min, float max)
-        : label(font, labelText), value(val), minValue(min), maxValue(max) {
+    Slider(const sf::Font& font, const std::string& name, float* val, float min, float max)
+        : label(font, ""), value(val), minValue(min), maxValue(max), valueLabel(prefixedLabel(name + ": ", "%")) {
         track.setSize(sf::Vector2f(200.f, 10.f));
         track.setFillColor(sf::Color(100, 100, 100));
         handle.setSize(sf::Vector2f(20.f, 20.f));
         handle.setFillColor(sf::Color::White);
         label.setCharacterSize(20);
         label.setFillColor(sf::Color::White);
+        refreshLabel();
+    }
+
+    void refreshLabel() {
+        valueLabel.update(label, static_cast<int>(*value * 100));
     }
 
     void setPosition(float x, float y) {
@@ -100,50 +150,120 @@ struct Slider {
     }
 };
 
-const int CELL_SIZE = 30;
-const int BOARD_WIDTH = 10;
-const int BOARD_HEIGHT = 20;
-const int TITLEBAR_HEIGHT = 30;
-const int WINDOW_WIDTH = CELL_SIZE * BOARD_WIDTH + 300;
-const int WINDOW_HEIGHT = CELL_SIZE * BOARD_HEIGHT + TITLEBAR_HEIGHT;
+// Board size is fixed at compile time, e.g. -DGAME_BOARD_WIDTH=16 -DGAME_BOARD_HEIGHT=40.
+// The automatic player and replay recording only exist for the classic 10x20 board.
+#ifndef GAME_BOARD_WIDTH
+#define GAME_BOARD_WIDTH 10
+#endif
+#ifndef GAME_BOARD_HEIGHT
+#define GAME_BOARD_HEIGHT 20
+#endif
 
-using ShapeMatrix = std::vector<std::vector<int>>;
+using GameEngine = BasicEngine<GAME_BOARD_WIDTH, GAME_BOARD_HEIGHT>;
+using GameBoard = GameEngine::BoardType;
+const bool CLASSIC_BOARD = std::is_same_v<GameEngine, TetrisEngine>;
 
-struct Piece {
-    char shape;
-    int rotation;
-    sf::Color color;
-    int x, y;
+// Cells shrink so tall or wide boards still fit on screen; 30 px on the classic board
+const int CELL_SIZE = std::clamp(std::min(900 / GameBoard::HEIGHT, 1200 / GameBoard::WIDTH), 1, 30);
+const int CELL_GAP = CELL_SIZE >= 8 ? 1 : 0;
+const int PREVIEW_CELL_SIZE = 30;
+const int PLAYFIELD_WIDTH = CELL_SIZE * GameBoard::WIDTH;
+const int PLAYFIELD_HEIGHT = CELL_SIZE * GameBoard::HEIGHT;
+const int TITLEBAR_HEIGHT = 30;
+const int WINDOW_WIDTH = std::max(PLAYFIELD_WIDTH + 300, 600);
+const int WINDOW_HEIGHT = std::max(PLAYFIELD_HEIGHT, 600) + TITLEBAR_HEIGHT;
+const int IDLE_TIMEOUT_MS = 250; // longest an idle menu blocks waiting for input
+const char SAVE_PATH[] = "gamedata.dat";
+
+// Command line switches for the windowed game
+struct AppOptions {
+    bool renderStats = false; // --render-stats: print draw calls and text rebuilds per frame once a second
+    int tickRate = 60;        // --tick-rate N: fixed simulation ticks per second
+    bool simThread = false;   // --sim-thread: run the game core on its own thread
+    bool cpuStats = false;    // --cpu-stats: print CPU time per minute of wall time
+    bool startupStats = false; // --startup-stats: print startup stage timings and time to first frame
+    bool fixedSeed = false;   // --seed S: game n uses seed S + n instead of a random seed
+    uint32_t seed = 0;
+    std::string recordPath;   // --record FILE: write each finished game's replay to FILE
+    bool bot = false;         // --bot: the automatic player drives the game and restarts it on game over
+    float botPps = 2.0f;      // --bot-pps N: pieces per second the bot may place
+    int botThreads = 0;       // --bot-threads T: search threads, 0 for one per core
+    bool benchmark = false;   // hidden window, no frame limit; set by the benchmark suite
+    bool profile = false;     // --profile: start with the profiler overlay shown (F3 toggles it)
+    std::string tracePath = "trace.json"; // --trace FILE: record a Chrome trace from startup to exit into FILE
+    bool traceAtStart = false;
 };
 
-const std::array<std::pair<char, ShapeMatrix>, 7> SHAPES = {{
-    {'I', {{1,1,1,1}}},
-    {'J', {{1,0,0},{1,1,1}}},
-    {'L', {{0,0,1},{1,1,1}}},
-    {'O', {{1,1},{1,1}}},
-    {'S', {{0,1,1},{1,1,0}}},
-    {'T', {{0,1,0},{1,1,1}}},
-    {'Z', {{1,1,0},{0,1,1}}}
-}};
-
-const std::map<char, sf::Color> COLORS = {
-    {'I', sf::Color::Cyan},
-    {'J', sf::Color::Blue},
-    {'L', sf::Color(255,165,0)}, // Orange
-    {'O', sf::Color::Yellow},
-    {'S', sf::Color::Green},
-    {'T', sf::Color(128,0,128)}, // Purple
-    {'Z', sf::Color::Red}
+// Everything loaded from disk or generated off the main thread during startup
+struct StartupAssets {
+    sf::Font font;
+    bool fontLoaded = false;
+    sf::Image icon;
+    bool iconLoaded = false;
+    std::vector<sf::Vector2f> stars;
+    SaveData save;
+    bool saveLoaded = false;
 };
 
+inline AppOptions parseAppOptions(int argc, char** argv) {
+    AppOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--render-stats") options.renderStats = true;
+        else if (arg == "--tick-rate" && i + 1 < argc) options.tickRate = std::clamp(std::atoi(argv[++i]), 1, static_cast<int>(MAX_REPLAY_TICK_RATE));
+        else if (arg == "--sim-thread") options.simThread = true;
+        else if (arg == "--cpu-stats") options.cpuStats = true;
+        else if (arg == "--startup-stats") options.startupStats = true;
+        else if (arg == "--seed" && i + 1 < argc) {
+            options.fixedSeed = true;
+            options.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--record" && i + 1 < argc) options.recordPath = argv[++i];
+        else if (arg == "--bot") options.bot = true;
+        else if (arg == "--bot-pps" && i + 1 < argc) options.botPps = std::max(0.1f, static_cast<float>(std::atof(argv[++i])));
+        else if (arg == "--bot-threads" && i + 1 < argc) options.botThreads = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--profile") options.profile = true;
+        else if (arg == "--trace" && i + 1 < argc) {
+            options.traceAtStart = true;
+            options.tracePath = argv[++i];
+        }
+    }
+    if (!CLASSIC_BOARD && (options.bot || !options.recordPath.empty())) {
+        std::cerr << "--bot and --record need the classic 10x20 board; ignoring them" << std::endl;
+        options.bot = false;
+        options.recordPath.clear();
+    }
+    return options;
+}
+
+// The automatic player searches the classic board; other sizes get no placement
+inline Placement searchPlacement(PlacementSearch& search, const BoardRows& rows, const Piece& current, const Piece& next) {
+    return search.best(rows, current, next);
+}
+
+template<class Rows>
+Placement searchPlacement(PlacementSearch&, const Rows&, const Piece&, const Piece&) {
+    return Placement();
+}
+
 class TetrisApp {
 public:
-    TetrisApp() : window(sf::VideoMode({WINDOW_WIDTH, WINDOW_HEIGHT}), "Tetris Clone C++", sf::Style::None),
-                  board(BOARD_HEIGHT, std::vector<sf::Color>(BOARD_WIDTH, sf::Color::Black)),
+    TetrisApp(const AppOptions& appOptions = AppOptions()) : options(appOptions), window(sf::VideoMode({WINDOW_WIDTH, WINDOW_HEIGHT}), "Tetris Clone C++", sf::Style::None),
+                  engine(static_cast<uint32_t>(std::chrono::system_clock::now().time_since_epoch().count())),
+                  simulation(engine, appOptions.tickRate),
                   rng(std::chrono::system_clock::now().time_since_epoch().count()),
                   wobbleEnabled(true), dragging(false),
-                  font(), gameState(GameState::MainMenu) {
-        window.setFramerateLimit(60);
+                  font(), gameState(GameState::Loading) {
+        startup.record("window", 0.0, msSinceProcessStart());
+        profilerOverlay = options.profile;
+        profiler().setOverlay(profilerOverlay);
+        if (options.traceAtStart) {
+            profiler().startTrace();
+        }
+        window.setFramerateLimit(options.benchmark ? 0 : 60);
+        if (options.benchmark) {
+            window.setVisible(false);
+        }
         currentWindowSize = window.getSize();
         
         // Center the window on screen
@@ -152,17 +272,255 @@ public:
         int centerY = (desktop.size.y - WINDOW_HEIGHT) / 2;
         window.setPosition(sf::Vector2i(centerX, centerY));
 
-        // Load font first
-        if (!font.openFromFile("/usr/share/fonts/TTF/DejaVuSans.ttf")) {
-            if (!font.openFromFile("/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf")) {
-                if (!font.openFromFile("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf")) {
-                    // If all else fails, try to use system default font
-                    std::cerr << "Warning: Could not load any fonts. Using system default." << std::endl;
+        // Fonts, icon and stars load on a worker while the first frame goes up
+        unsigned starSeed = static_cast<unsigned>(rng());
+        assetLoad = std::async(std::launch::async, [this, starSeed]() { return loadAssets(starSeed); });
+
+        // Initialize titlebar
+        titlebar.setSize(sf::Vector2f(WINDOW_WIDTH, TITLEBAR_HEIGHT));
+        titlebar.setPosition(sf::Vector2f(0, 0));
+        titlebar.setFillColor(sf::Color(0, 0, 0, 128)); // Semi-transparent
+
+        closeButton.setSize(sf::Vector2f(30, 30));
+        closeButton.setPosition(sf::Vector2f(WINDOW_WIDTH - 30, 0));
+        closeButton.setFillColor(sf::Color::Red);
+
+        minimizeButton.setSize(sf::Vector2f(30, 30));
+        minimizeButton.setPosition(sf::Vector2f(WINDOW_WIDTH - 60, 0));
+        minimizeButton.setFillColor(sf::Color::Yellow);
+
+        // Rainbow mode recolours pieces as they spawn. This may run on the simulation
+        // thread, so it reads a colour the render loop publishes instead of the clock.
+        engine.onNewPiece = [this](Piece& piece) {
+            if (uint32_t tint = spawnTint.load()) {
+                piece.color = tint;
+            }
+        };
+
+        resetGame();
+
+        // First frame: just the empty window and titlebar, nothing here waits on the disk
+        window.clear(sf::Color::Black);
+        window.draw(titlebar);
+        window.draw(closeButton);
+        window.draw(minimizeButton);
+        window.display();
+        startup.markFirstFrame();
+    }
+
+    // Input and rendering run every frame; the game itself advances in fixed ticks,
+    // either inline here or on the simulation thread
+    void run() {
+        sf::Clock frameClock;
+        if (options.simThread) {
+            simulation.startThread();
+        }
+        while (window.isOpen()) {
+            frameStartUs = Profiler::nowUs();
+            if (canIdle()) {
+                // Nothing moves on its own: sleep until input arrives, redraw only if something happened
+                if (const std::optional<sf::Event> event = window.waitEvent(sf::milliseconds(IDLE_TIMEOUT_MS))) {
+                    frameStartUs = Profiler::nowUs(); // the wait itself is not frame work
+                    handleEvent(*event);
                 }
+                handleEvents();
+                idleWaits++;
+            } else {
+                handleEvents();
+                redrawNeeded = true;
+            }
+            if (gameState == GameState::Loading) {
+                pollStartup();
+            }
+            simulation.setPaused(gameState != GameState::Game || isMinimized);
+            spawnTint = modRainbow ? getRainbowColor().toInteger() : 0;
+            if (!simulation.threaded()) {
+                ProfileScope scope("simulate");
+                simulation.advance(frameClock.restart().asSeconds());
+            }
+            update();
+            if (redrawNeeded) {
+                draw();
+                redrawNeeded = false;
             }
+            recordCpuStats();
+            recordBotStats();
         }
+        simulation.stopThread();
+        if (profiler().traceRunning()) {
+            stopTrace();
+        }
+    }
 
-        // Initialize text objects after font is loaded
+    // Benchmark hook: waits for startup, then times `frames` frames of a game in progress
+    // (one simulation tick and a full draw() each) into the hidden window. Skips update(),
+    // so no music plays and no coins are saved.
+    double benchmarkFrames(long long frames) {
+        while (gameState == GameState::Loading) {
+            pollStartup();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const Input inputs[4] = {Input::Left, Input::Rotate, Input::Right, Input::HardDrop};
+        sf::Clock clock;
+        for (long long i = 0; i < frames; ++i) {
+            if (gameState != GameState::Game || snapshot.gameOver) {
+                resetGame();
+                gameState = GameState::Game;
+            }
+            frameStartUs = Profiler::nowUs();
+            if (i % 8 == 0) {
+                simulation.queueInput(inputs[(i / 8) % 4]);
+            }
+            simulation.advance(simulation.tickSeconds());
+            simulation.latest(snapshot);
+            draw();
+        }
+        return clock.getElapsedTime().asSeconds();
+    }
+
+    // --alloc-check: plays a scripted game into the hidden window, the whole frame (events,
+    // simulation, update() and draw()) each time, and fails if any frame after the warm-up allocates
+    bool allocationCheck(const AllocationCheckOptions& check) {
+        while (gameState == GameState::Loading) {
+            pollStartup();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return checkFrameAllocations(check, [this](long long i) {
+            if (gameState != GameState::Game) {
+                resetGame();
+                gameState = GameState::Game;
+            }
+            handleEvents();
+            if (Input input = allocationCheckInput(i); input != Input::None) {
+                simulation.queueInput(input);
+            }
+            simulation.advance(simulation.tickSeconds());
+            update();
+            draw();
+        });
+    }
+
+private:
+    // True when nothing on screen animates by itself (falling piece, rainbow colours,
+    // wobble, drags), so the loop can block on input instead of running at 60 FPS
+    bool canIdle() const {
+        if (wobbleActive || dragging || gameState == GameState::Loading) return false;
+        if (isMinimized) return true; // the game is paused while minimized
+        if (gameState == GameState::Game) return false;
+        for (const auto& slider : sliders) {
+            if (slider.isDragging) return false;
+        }
+        return true;
+    }
+
+    // Attract mode: plays whenever a game is on, restarts after game over
+    void driveBot() {
+        if (!bot || isMinimized) return;
+        if (gameState == GameState::GameOver) {
+            resetGame();
+            gameState = GameState::Game;
+            return;
+        }
+        if (gameState != GameState::Game || snapshot.gameOver) return;
+        // One placement per new piece, and no faster than the pieces-per-second budget
+        if (snapshot.blocksPlaced == botPiecesHandled || botClock.getElapsedTime().asSeconds() < 1.0f / options.botPps) return;
+        Placement placement = searchPlacement(*bot, snapshot.board.occupancy(), snapshot.currentPiece, snapshot.nextPiece);
+        if (placement.valid) {
+            for (Input input : bot->inputsFor(placement)) {
+                simulation.queueInput(input);
+            }
+        } else {
+            simulation.queueInput(Input::HardDrop);
+        }
+        botPiecesHandled = snapshot.blocksPlaced;
+        botPieces++;
+        botClock.restart();
+    }
+
+    void recordBotStats() {
+        if (!bot || botStatsClock.getElapsedTime().asSeconds() < 5.0f) {
+            return;
+        }
+        double seconds = botStatsClock.restart().asSeconds();
+        long long nodes = bot->nodes();
+        std::cout << "bot: " << (nodes - botStatsNodes) / seconds << " nodes/sec, "
+                  << botPieces / seconds << " pieces/sec" << std::endl;
+        botStatsNodes = nodes;
+        botPieces = 0;
+    }
+
+    void recordCpuStats() {
+        if (!options.cpuStats || cpuMeter.wallSeconds() < 60.0) {
+            return;
+        }
+        std::cout << "cpu time/min: " << cpuMeter.cpuSecondsPerMinute() << " s, idle waits: " << idleWaits << std::endl;
+        cpuMeter.restart();
+        idleWaits = 0;
+    }
+
+    // Runs on the loading thread: only touches its own locals and the thread-safe timeline
+    StartupAssets loadAssets(unsigned starSeed) {
+        StartupAssets assets;
+        startup.measure("font", [&]() {
+            assets.fontLoaded = assets.font.openFromFile("/usr/share/fonts/TTF/DejaVuSans.ttf") ||
+                                assets.font.openFromFile("/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf") ||
+                                assets.font.openFromFile("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+        }, true);
+        startup.measure("icon", [&]() { assets.iconLoaded = assets.icon.loadFromFile("tetris.ico"); }, true);
+        startup.measure("save", [&]() { assets.saveLoaded = loadSaveFile(SAVE_PATH, assets.save); }, true);
+
+        // Generate space background stars
+        startup.measure("stars", [&]() {
+            std::mt19937 starRng(starSeed);
+            std::uniform_real_distribution<float> distX(0, WINDOW_WIDTH);
+            std::uniform_real_distribution<float> distY(TITLEBAR_HEIGHT, WINDOW_HEIGHT);
+            for (int i = 0; i < 100; ++i) {
+                assets.stars.emplace_back(distX(starRng), distY(starRng));
+            }
+        }, true);
+        return assets;
+    }
+
+    // Polled every frame while loading; the rest of startup needs the window, so it runs here
+    void pollStartup() {
+        if (assetLoad.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
+        StartupAssets assets = assetLoad.get();
+        if (!assets.fontLoaded) {
+            // If all else fails, try to use system default font
+            std::cerr << "Warning: Could not load any fonts. Using system default." << std::endl;
+        }
+        font = std::move(assets.font);
+        if (assets.iconLoaded) {
+            window.setIcon(sf::Vector2u(assets.icon.getSize().x, assets.icon.getSize().y), assets.icon.getPixelsPtr());
+        }
+        stars = std::move(assets.stars);
+        applySaveData(assets.save); // a legacy save was already rewritten by loadSaveFile
+
+        startup.measure("text", [this]() { initializeText(); });
+        startup.measure("menus", [this]() { initializeMenus(); });
+        startup.measure("music", [this]() { initializeMusic(); });
+        startup.measure("render textures", [this]() {
+            backgroundCache.resize(sf::Vector2u(WINDOW_WIDTH, WINDOW_HEIGHT));
+            boardCache.resize(sf::Vector2u(WINDOW_WIDTH, WINDOW_HEIGHT));
+            hudCache.resize(sf::Vector2u(WINDOW_WIDTH, WINDOW_HEIGHT));
+        });
+        gameState = GameState::MainMenu;
+        if (options.bot) {
+            bot = std::make_unique<PlacementSearch>(options.botThreads);
+            resetGame();
+            gameState = GameState::Game;
+        }
+        redrawNeeded = true;
+        startup.markReady();
+        if (options.startupStats) {
+            startup.report(std::cout);
+        }
+    }
+
+    // Text objects need the font, so they are built once it has loaded
+    void initializeText() {
         titleText = sf::Text(font, "Tetris Clone", 48);
         titleText->setFillColor(sf::Color::White);
         titleText->setPosition(sf::Vector2f(WINDOW_WIDTH / 2 - 150, 50 + TITLEBAR_HEIGHT));
@@ -173,50 +531,46 @@ public:
 
         backText = sf::Text(font, "Back to Menu", 24);
         backText->setFillColor(sf::Color::White);
-        backText->setPosition(sf::Vector2f(static_cast<float>(CELL_SIZE * BOARD_WIDTH + 10), 130.f + TITLEBAR_HEIGHT));
+        backText->setPosition(sf::Vector2f(static_cast<float>(PLAYFIELD_WIDTH + 10), 130.f + TITLEBAR_HEIGHT));
 
         backRect.setSize(sf::Vector2f(150.f, 30.f));
-        backRect.setPosition(sf::Vector2f(static_cast<float>(CELL_SIZE * BOARD_WIDTH + 10), 130.f + TITLEBAR_HEIGHT));
+        backRect.setPosition(sf::Vector2f(static_cast<float>(PLAYFIELD_WIDTH + 10), 130.f + TITLEBAR_HEIGHT));
+
+        // Built once: a shape allocates its vertices, so the HUD repaint must not make a new one
+        scoreBorder.setSize(sf::Vector2f(WINDOW_WIDTH - PLAYFIELD_WIDTH - 2, WINDOW_HEIGHT - TITLEBAR_HEIGHT - 2));
+        scoreBorder.setPosition(sf::Vector2f(PLAYFIELD_WIDTH + 1, TITLEBAR_HEIGHT - 1));
+        scoreBorder.setFillColor(sf::Color::Transparent);
+        scoreBorder.setOutlineColor(sf::Color::White);
+        scoreBorder.setOutlineThickness(1);
         backRect.setFillColor(sf::Color::Transparent);
 
         scoreText = sf::Text(font, "Score: 0", 24);
         scoreText->setFillColor(sf::Color::White);
-        scoreText->setPosition(sf::Vector2f(static_cast<float>(CELL_SIZE * BOARD_WIDTH + 10), 10.f + TITLEBAR_HEIGHT));
+        scoreText->setPosition(sf::Vector2f(static_cast<float>(PLAYFIELD_WIDTH + 10), 10.f + TITLEBAR_HEIGHT));
 
         levelText = sf::Text(font, "Level: 1", 24);
         levelText->setFillColor(sf::Color::White);
-        levelText->setPosition(sf::Vector2f(static_cast<float>(CELL_SIZE * BOARD_WIDTH + 10), 40.f + TITLEBAR_HEIGHT));
+        levelText->setPosition(sf::Vector2f(static_cast<float>(PLAYFIELD_WIDTH + 10), 40.f + TITLEBAR_HEIGHT));
 
         linesText = sf::Text(font, "Lines: 0", 24);
         linesText->setFillColor(sf::Color::White);
-        linesText->setPosition(sf::Vector2f(static_cast<float>(CELL_SIZE * BOARD_WIDTH + 10), 70.f + TITLEBAR_HEIGHT));
+        linesText->setPosition(sf::Vector2f(static_cast<float>(PLAYFIELD_WIDTH + 10), 70.f + TITLEBAR_HEIGHT));
 
         coinsText = sf::Text(font, "$ 0", 24);
         coinsText->setFillColor(sf::Color::Yellow);
-        coinsText->setPosition(sf::Vector2f(static_cast<float>(CELL_SIZE * BOARD_WIDTH + 10), 100.f + TITLEBAR_HEIGHT));
+        coinsText->setPosition(sf::Vector2f(static_cast<float>(PLAYFIELD_WIDTH + 10), 100.f + TITLEBAR_HEIGHT));
 
         mainMenuCoinsText = sf::Text(font, "$ 0", 24);
         mainMenuCoinsText->setFillColor(sf::Color::Yellow);
         mainMenuCoinsText->setPosition(sf::Vector2f(WINDOW_WIDTH / 2 + 100, 150 + TITLEBAR_HEIGHT));
-        
-        // Load icon
-        sf::Image icon;
-        if (icon.loadFromFile("tetris.ico")) {
-            window.setIcon(sf::Vector2u(icon.getSize().x, icon.getSize().y), icon.getPixelsPtr());
-        }
 
-        // Initialize titlebar
-        titlebar.setSize(sf::Vector2f(WINDOW_WIDTH, TITLEBAR_HEIGHT));
-        titlebar.setPosition(sf::Vector2f(0, 0));
-        titlebar.setFillColor(sf::Color(0, 0, 0, 128)); // Semi-transparent
-
-        closeButton.setSize(sf::Vector2f(30, 30));
-        closeButton.setPosition(sf::Vector2f(WINDOW_WIDTH - 30, 0));
-        closeButton.setFillColor(sf::Color::Red);
+        nextText = sf::Text(font, "Next:", 24);
+        nextText->setFillColor(sf::Color::White);
+        nextText->setPosition(sf::Vector2f(PLAYFIELD_WIDTH + 10, 200 + TITLEBAR_HEIGHT));
 
-        minimizeButton.setSize(sf::Vector2f(30, 30));
-        minimizeButton.setPosition(sf::Vector2f(WINDOW_WIDTH - 60, 0));
-        minimizeButton.setFillColor(sf::Color::Yellow);
+        gameOverText = sf::Text(font, "Game Over", 48);
+        gameOverText->setFillColor(sf::Color::Red);
+        gameOverText->setPosition(sf::Vector2f(WINDOW_WIDTH / 2 - 120.f, 150.f + TITLEBAR_HEIGHT));
 
         closeText = sf::Text(font, "x", 20);
         closeText->setFillColor(sf::Color::White);
@@ -225,41 +579,26 @@ public:
         minimizeText = sf::Text(font, "□", 20);
         minimizeText->setFillColor(sf::Color::Black);
         minimizeText->setPosition(sf::Vector2f(WINDOW_WIDTH - 55, 5));
-
-        resetGame();
-        initializeMenus();
-        generateTetrisTheme();
-
-        // Generate space background stars
-        stars.clear();
-        std::uniform_real_distribution<float> distX(0, WINDOW_WIDTH);
-        std::uniform_real_distribution<float> distY(TITLEBAR_HEIGHT, WINDOW_HEIGHT);
-        for (int i = 0; i < 100; ++i) {
-            stars.emplace_back(distX(rng), distY(rng));
-        }
-
     }
 
-    void run() {
-        while (window.isOpen()) {
-            handleEvents();
-            update();
-            draw();
-        }
-    }
-
-private:
+    AppOptions options;
     sf::RenderWindow window;
-    std::vector<std::vector<sf::Color>> board;
-    Piece currentPiece;
-    Piece nextPiece;
-    int score = 0;
-    int level = 1;
-    int linesCleared = 0;
+    GameEngine engine; // owned by the simulation once it runs; read snapshot instead
+    BasicSimulation<GameEngine> simulation;
+    BasicSnapshot<GameEngine> snapshot;
+    int locksSeen = 0;
+    uint32_t gamesStarted = 0;
+    std::future<void> replayWrite;
+
+    // Automatic player, only created with --bot
+    std::unique_ptr<PlacementSearch> bot;
+    int botPiecesHandled = -1; // blocksPlaced when the bot last queued a placement
+    long long botPieces = 0;
+    long long botStatsNodes = 0;
+    sf::Clock botClock;
+    sf::Clock botStatsClock;
+    std::atomic<uint32_t> spawnTint{0}; // rainbow colour for new pieces, 0 when off
     int coins = 0;
-    int blocksPlaced = 0;
-    int fallSpeed = 500; // milliseconds
-    sf::Clock fallClock;
     sf::Clock coinCooldownClock;
 
     // Wobble variables
@@ -292,7 +631,15 @@ private:
     std::optional<sf::Text> linesText = std::nullopt;
     std::optional<sf::Text> coinsText = std::nullopt;
     std::optional<sf::Text> mainMenuCoinsText = std::nullopt;
+    std::optional<sf::Text> nextText = std::nullopt;
+    std::optional<sf::Text> gameOverText = std::nullopt;
+    ValueLabel scoreLabel = prefixedLabel("Score: ");
+    ValueLabel levelLabel = prefixedLabel("Level: ");
+    ValueLabel linesLabel = prefixedLabel("Lines: ");
+    ValueLabel coinsLabel = prefixedLabel("$ ");
+    ValueLabel mainMenuCoinsLabel = prefixedLabel("$ ");
     sf::RectangleShape backRect;
+    sf::RectangleShape scoreBorder;
     
     // Sliders
     std::vector<Slider> sliders;
@@ -321,129 +668,95 @@ private:
     bool redWallpaperBought = false;
     std::string activeWallpaper = "space"; // "space", "blue", "green", "red"
 
+    // Batched playfield layers and per-frame draw call stats
+    CellLayer boardLayer;
+    CellLayer pieceLayer;
+    CellLayer ghostLayer;
+    CellLayer previewLayer;
+    CachedLayer backgroundCache;
+    CachedLayer boardCache;
+    CachedLayer hudCache;
+    int drawCalls = 0;
+    long long statsFrames = 0;
+    long long statsDrawCalls = 0;
+    int statsMaxDrawCalls = 0;
+    long long statsTextRebuilds = 0;
+    sf::Clock statsClock;
+
+    // Profiler overlay (F3) and frame timing; the text is rebuilt twice a second, not every frame
+    std::optional<sf::Text> profilerText = std::nullopt;
+    sf::RectangleShape profilerPanel;
+    sf::Clock profilerRefresh;
+    bool profilerOverlay = false;
+    int64_t frameStartUs = 0;
+    long long frameAllocations = 0; // allocation count when the last frame ended
+
+    // Idle frame pacing
+    bool redrawNeeded = true;
+    long long idleWaits = 0;
+    CpuMeter cpuMeter;
+
+    // Staged startup
+    StartupTimeline startup;
+    std::future<StartupAssets> assetLoad;
+
+    // Saves are written on their own thread; flushed when the app is destroyed
+    SaveWriter saveWriter{SAVE_PATH};
+
     // Audio system
-    sf::SoundBuffer tetrisBuffer;
-    std::optional<sf::Sound> tetrisMusic;
-    std::vector<int16_t> tetrisThemeSamples;
+    std::unique_ptr<ThemeStream> tetrisMusic;
     bool musicLoaded = false;
 
     std::mt19937 rng;
 
-    void generateTetrisTheme() {
-        // Generate the classic Tetris theme from Arduino notes
-        const int sampleRate = 44100;
-        const float duration = 0.25f; // Quarter note duration
-        const int noteSamples = static_cast<int>(sampleRate * duration);
-
-        // Tetris theme melody frequencies
-        std::vector<float> melody = {
-            659, 494, 523, 587, 659, 587, 523, 494,
-            440, 440, 523, 659, 587, 523,
-            494, 523, 587, 659, 523, 440, 440, 587,
-            587, 698, 880, 784, 698, 659, 523, 659,
-            587, 523, 494, 494, 523, 587, 659, 523,
-            440, 440
-        };
-
-        tetrisThemeSamples.clear();
-        tetrisThemeSamples.reserve(melody.size() * noteSamples);
-
-        for (float freq : melody) {
-            for (int i = 0; i < noteSamples; ++i) {
-                float time = static_cast<float>(i) / sampleRate;
-                float amplitude = freq > 0 ? 0.3f * std::sin(2.0f * M_PI * freq * time) : 0.0f;
-
-                // Apply envelope for smoother sound
-                float envelope = 1.0f;
-                if (i < noteSamples * 0.1f) {
-                    envelope = static_cast<float>(i) / (noteSamples * 0.1f); // Attack
-                } else if (i > noteSamples * 0.8f) {
-                    envelope = 1.0f - static_cast<float>(i - noteSamples * 0.8f) / (noteSamples * 0.2f); // Release
-                }
-
-                int16_t sample = static_cast<int16_t>(amplitude * envelope * 32767);
-                tetrisThemeSamples.push_back(sample);
-            }
-        }
-
-        std::vector<sf::SoundChannel> channels = {sf::SoundChannel::Mono};
-        if (tetrisBuffer.loadFromSamples(tetrisThemeSamples.data(), tetrisThemeSamples.size(), 1, sampleRate, channels)) {
-            tetrisMusic = sf::Sound(tetrisBuffer);
-            tetrisMusic->setLooping(true);
-            tetrisMusic->setVolume(soundVolume * 100.0f); // Adjust volume scale
-            musicLoaded = true;
-        } else {
-            std::cerr << "Failed to load Tetris theme" << std::endl;
-        }
+    // The theme is synthesized on the audio thread as it plays, nothing is pre-rendered
+    void initializeMusic() {
+        tetrisMusic = std::make_unique<ThemeStream>();
+        tetrisMusic->setVolume(soundVolume * 100.0f); // Adjust volume scale
+        musicLoaded = true;
     }
 
+    // Every game gets its own seed, so any game can be replayed from its recording
     void resetGame() {
-        for (auto& row : board) {
-            std::fill(row.begin(), row.end(), sf::Color::Black);
-        }
-        score = 0;
-        level = 1;
-        linesCleared = 0;
-        fallSpeed = 500;
-        currentPiece = getNewPiece();
-        nextPiece = getNewPiece();
-        fallClock.restart();
-        blocksPlaced = 0;
+        uint32_t seed = options.fixedSeed ? options.seed + gamesStarted : static_cast<uint32_t>(rng());
+        gamesStarted++;
+        simulation.reset(seed);
+        botPiecesHandled = -1;
+        simulation.latest(snapshot);
+        locksSeen = 0;
     }
 
+    // Queues a save; the writer thread does the disk I/O
     void saveCoins() {
-        std::ofstream file("gamedata.dat", std::ios::binary);
-        if (file.is_open()) {
-            file.write(reinterpret_cast<const char*>(&coins), sizeof(coins));
-            file.write(reinterpret_cast<const char*>(&blueWallpaperBought), sizeof(blueWallpaperBought));
-            file.write(reinterpret_cast<const char*>(&greenWallpaperBought), sizeof(greenWallpaperBought));
-            file.write(reinterpret_cast<const char*>(&redWallpaperBought), sizeof(redWallpaperBought));
-            file.write(reinterpret_cast<const char*>(&spaceBackgroundEnabled), sizeof(spaceBackgroundEnabled));
-            
-            // Save active wallpaper string
-            size_t len = activeWallpaper.length();
-            file.write(reinterpret_cast<const char*>(&len), sizeof(len));
-            file.write(activeWallpaper.c_str(), len);
-            
-            file.close();
-        } else {
-            std::cerr << "Failed to save game data to file." << std::endl;
+        ProfileScope scope("saveCoins");
+        if (gameState == GameState::Loading) {
+            return; // the save has not been read yet, don't overwrite it with defaults
         }
+        SaveData data;
+        data.coins = coins;
+        data.blueWallpaperBought = blueWallpaperBought;
+        data.greenWallpaperBought = greenWallpaperBought;
+        data.redWallpaperBought = redWallpaperBought;
+        data.spaceBackgroundEnabled = spaceBackgroundEnabled;
+        data.activeWallpaper = activeWallpaper;
+        saveWriter.save(data);
     }
 
-    void loadCoins() {
-        std::ifstream file("gamedata.dat", std::ios::binary);
-        if (file.is_open()) {
-            file.read(reinterpret_cast<char*>(&coins), sizeof(coins));
-            file.read(reinterpret_cast<char*>(&blueWallpaperBought), sizeof(blueWallpaperBought));
-            file.read(reinterpret_cast<char*>(&greenWallpaperBought), sizeof(greenWallpaperBought));
-            file.read(reinterpret_cast<char*>(&redWallpaperBought), sizeof(redWallpaperBought));
-            file.read(reinterpret_cast<char*>(&spaceBackgroundEnabled), sizeof(spaceBackgroundEnabled));
-            
-            // Load active wallpaper string
-            size_t len;
-            if (file.read(reinterpret_cast<char*>(&len), sizeof(len))) {
-                activeWallpaper.resize(len);
-                file.read(&activeWallpaper[0], len);
-                
-                // Set background color based on active wallpaper
-                if (activeWallpaper == "blue") backgroundColor = sf::Color::Blue;
-                else if (activeWallpaper == "green") backgroundColor = sf::Color::Green;
-                else if (activeWallpaper == "red") backgroundColor = sf::Color::Red;
-                else backgroundColor = sf::Color::Black;
-            }
-            
-            file.close();
-        } else {
-            // Default values if no file found
-            coins = 0;
-            blueWallpaperBought = false;
-            greenWallpaperBought = false;
-            redWallpaperBought = false;
-            spaceBackgroundEnabled = true;
-            activeWallpaper = "space";
-            backgroundColor = sf::Color::Black;
-        }
+    // The save is read once during startup; after that the in-memory values are authoritative
+    void applySaveData(const SaveData& data) {
+        coins = data.coins;
+        blueWallpaperBought = data.blueWallpaperBought;
+        greenWallpaperBought = data.greenWallpaperBought;
+        redWallpaperBought = data.redWallpaperBought;
+        spaceBackgroundEnabled = data.spaceBackgroundEnabled;
+        activeWallpaper = data.activeWallpaper;
+
+        // Set background color based on active wallpaper
+        if (activeWallpaper == "blue") backgroundColor = sf::Color::Blue;
+        else if (activeWallpaper == "green") backgroundColor = sf::Color::Green;
+        else if (activeWallpaper == "red") backgroundColor = sf::Color::Red;
+        else backgroundColor = sf::Color::Black;
+        backgroundCache.markDirty();
     }
 
     sf::Color getRainbowColor() {
@@ -454,118 +767,46 @@ private:
         return sf::Color(r, g, b);
     }
 
-    Piece getNewPiece() {
-        std::uniform_int_distribution<int> dist(0, SHAPES.size() - 1);
-        int idx = dist(rng);
-        char shape = SHAPES[idx].first;
-        sf::Color color = COLORS.at(shape);
-        if (modRainbow) {
-            color = getRainbowColor();
-        }
-        return Piece{shape, 0, color, BOARD_WIDTH / 2 - 2, 0};
-    }
-
-    ShapeMatrix rotateShape(const ShapeMatrix& matrix) {
-        int n = matrix.size();
-        int m = matrix[0].size();
-        ShapeMatrix rotated(m, std::vector<int>(n, 0));
-        for (int i = 0; i < n; ++i)
-            for (int j = 0; j < m; ++j)
-                rotated[j][n - i - 1] = matrix[i][j];
-        return rotated;
-    }
-
-    ShapeMatrix getShapeMatrix(const Piece& piece) {
-        ShapeMatrix matrix;
-        for (const auto& s : SHAPES) {
-            if (s.first == piece.shape) {
-                matrix = s.second;
-                break;
-            }
-        }
-        for (int i = 0; i < piece.rotation; ++i) {
-            matrix = rotateShape(matrix);
-        }
-        return matrix;
-    }
-
-    bool validPosition(const Piece& piece, int adjX = 0, int adjY = 0, int rotation = -1) {
-        int rot = (rotation == -1) ? piece.rotation : rotation;
-        ShapeMatrix matrix = getShapeMatrix(Piece{piece.shape, rot, piece.color, piece.x, piece.y});
-        for (int y = 0; y < (int)matrix.size(); ++y) {
-            for (int x = 0; x < (int)matrix[y].size(); ++x) {
-                if (matrix[y][x]) {
-                    int newX = piece.x + x + adjX;
-                    int newY = piece.y + y + adjY;
-                    if (newX < 0 || newX >= BOARD_WIDTH || newY >= BOARD_HEIGHT)
-                        return false;
-                    if (newY >= 0 && board[newY][newX] != sf::Color::Black)
-                        return false;
-                }
-            }
-        }
-        return true;
-    }
-
-    void placePiece() {
-        ShapeMatrix matrix = getShapeMatrix(currentPiece);
-        for (int y = 0; y < (int)matrix.size(); ++y) {
-            for (int x = 0; x < (int)matrix[y].size(); ++x) {
-                if (matrix[y][x]) {
-                    int boardX = currentPiece.x + x;
-                    int boardY = currentPiece.y + y;
-                    if (boardY >= 0 && boardY < BOARD_HEIGHT && boardX >= 0 && boardX < BOARD_WIDTH) {
-                        board[boardY][boardX] = currentPiece.color;
-                    }
-                }
-            }
-        }
-        score += 1; // +1 point for each block placed
-        clearLines();
-        blocksPlaced++;
+    // Called once for every piece the simulation locked, with the running block count
+    void onPieceLocked(int blocksPlaced) {
         if (blocksPlaced % 5 == 0) {
             if (coinCooldownClock.getElapsedTime().asSeconds() >= 4.0f) {
                 coins += 4;
                 coinCooldownClock.restart();
             }
         }
-        currentPiece = nextPiece;
-        nextPiece = getNewPiece();
-        if (!validPosition(currentPiece)) {
-            gameOver();
-        }
     }
 
-    void clearLines() {
-        for (int y = BOARD_HEIGHT - 1; y >= 0; --y) {
-            bool fullLine = true;
-            for (int x = 0; x < BOARD_WIDTH; ++x) {
-                if (board[y][x] == sf::Color::Black) {
-                    fullLine = false;
-                    break;
-                }
-            }
-            if (fullLine) {
-                for (int row = y; row > 0; --row) {
-                    board[row] = board[row - 1];
-                }
-                board[0] = std::vector<sf::Color>(BOARD_WIDTH, sf::Color::Black);
-                ++linesCleared;
-                score += 100 * level;
-                level = linesCleared / 10 + 1;
-                fallSpeed = std::max(100, 500 - (level - 1) * 50);
-                ++y; // recheck this row
-            }
+    // Picks up the newest simulation snapshot and reacts to what happened since the last one
+    void syncSnapshot() {
+        if (!simulation.latest(snapshot)) {
+            return;
+        }
+        while (locksSeen < snapshot.blocksPlaced) {
+            onPieceLocked(++locksSeen);
+        }
+        if (snapshot.gameOver && gameState == GameState::Game) {
+            gameOver();
         }
     }
 
     void gameOver() {
         gameState = GameState::GameOver;
+        if (!options.recordPath.empty()) {
+            // Written off the UI thread; waits for the previous write if one is still running
+            replayWrite = std::async(std::launch::async, [path = options.recordPath, replay = simulation.recording()]() {
+                if (!writeReplayFile(path, replay)) {
+                    std::cerr << "Failed to write replay " << path << std::endl;
+                }
+            });
+        }
     }
 
 
 
     void initializeMenus() {
+        markAllLayersDirty();
+
         // Get actual window size for dynamic positioning
         sf::Vector2u windowSize = window.getSize();
         float centerX = windowSize.x / 2.0f;
@@ -585,7 +826,7 @@ private:
         // Center text within button
         sf::FloatRect textBounds = playButton.text.getGlobalBounds();
         playButton.text.setPosition(sf::Vector2f(centerX - textBounds.size.x / 2.0f, 180.f + TITLEBAR_HEIGHT));
-        playButton.action = [this]() { loadCoins(); resetGame(); gameState = GameState::Game; };
+        playButton.action = [this]() { resetGame(); gameState = GameState::Game; };
         mainButtons.push_back(playButton);
 
         Button optionsButton(font);
@@ -652,13 +893,13 @@ private:
 
         // Initialize sliders
         sliders.clear();
-        sliders.emplace_back(font, "Brightness: " + std::to_string(brightness), &brightness, 0.3f, 1.5f);
+        sliders.emplace_back(font, "Brightness", &brightness, 0.3f, 1.5f);
         sliders.back().setPosition(50.f, 150.f + TITLEBAR_HEIGHT);
 
-        sliders.emplace_back(font, "Volume: " + std::to_string(soundVolume), &soundVolume, 0.0f, 1.0f);
+        sliders.emplace_back(font, "Volume", &soundVolume, 0.0f, 1.0f);
         sliders.back().setPosition(50.f, 200.f + TITLEBAR_HEIGHT);
 
-        sliders.emplace_back(font, "Rainbow Speed: " + std::to_string(rainbowSpeed), &rainbowSpeed, 0.1f, 3.0f);
+        sliders.emplace_back(font, "Rainbow Speed", &rainbowSpeed, 0.1f, 3.0f);
         sliders.back().setPosition(50.f, 250.f + TITLEBAR_HEIGHT);
 
         Button wobbleButton(font);
@@ -666,7 +907,9 @@ private:
         wobbleButton.rect.setPosition(sf::Vector2f(WINDOW_WIDTH / 2 - 100.f, 320.f + TITLEBAR_HEIGHT));
         wobbleButton.rect.setFillColor(sf::Color::Cyan);
         wobbleButton.text.setFont(font);
-        wobbleButton.text.setString(wobbleEnabled ? "Window Wobble: On" : "Window Wobble: Off");
+        wobbleButton.boundValue = [this]() { return wobbleEnabled; };
+        wobbleButton.label = toggleLabel("Window Wobble");
+        wobbleButton.refresh();
         wobbleButton.text.setCharacterSize(24);
         wobbleButton.text.setFillColor(sf::Color::Black);
         wobbleButton.text.setPosition(sf::Vector2f(WINDOW_WIDTH / 2 - 90.f, 330.f + TITLEBAR_HEIGHT));
@@ -682,7 +925,9 @@ private:
         rainbowButton.rect.setPosition(sf::Vector2f(WINDOW_WIDTH / 2 - 100.f, 150.f + TITLEBAR_HEIGHT));
         rainbowButton.rect.setFillColor(sf::Color::Magenta);
         rainbowButton.text.setFont(font);
-        rainbowButton.text.setString(modRainbow ? "Rainbow Mode: On" : "Rainbow Mode: Off");
+        rainbowButton.boundValue = [this]() { return modRainbow; };
+        rainbowButton.label = toggleLabel("Rainbow Mode");
+        rainbowButton.refresh();
         rainbowButton.text.setCharacterSize(24);
         rainbowButton.text.setFillColor(sf::Color::White);
         rainbowButton.text.setPosition(sf::Vector2f(WINDOW_WIDTH / 2 - 85.f, 160.f + TITLEBAR_HEIGHT));
@@ -737,12 +982,14 @@ private:
                 activeWallpaper = "blue";
                 spaceBackgroundEnabled = false;
                 backgroundColor = sf::Color::Blue;
+                backgroundCache.markDirty();
                 saveCoins();
                 initializeMenus(); // Refresh menu to update button text
             } else if (blueWallpaperBought) {
                 activeWallpaper = "blue";
                 spaceBackgroundEnabled = false;
                 backgroundColor = sf::Color::Blue;
+                backgroundCache.markDirty();
                 saveCoins();
             }
         };
@@ -765,12 +1012,14 @@ private:
                 activeWallpaper = "green";
                 spaceBackgroundEnabled = false;
                 backgroundColor = sf::Color::Green;
+                backgroundCache.markDirty();
                 saveCoins();
                 initializeMenus(); // Refresh menu to update button text
             } else if (greenWallpaperBought) {
                 activeWallpaper = "green";
                 spaceBackgroundEnabled = false;
                 backgroundColor = sf::Color::Green;
+                backgroundCache.markDirty();
                 saveCoins();
             }
         };
@@ -793,12 +1042,14 @@ private:
                 activeWallpaper = "red";
                 spaceBackgroundEnabled = false;
                 backgroundColor = sf::Color::Red;
+                backgroundCache.markDirty();
                 saveCoins();
                 initializeMenus(); // Refresh menu to update button text
             } else if (redWallpaperBought) {
                 activeWallpaper = "red";
                 spaceBackgroundEnabled = false;
                 backgroundColor = sf::Color::Red;
+                backgroundCache.markDirty();
                 saveCoins();
             }
         };
@@ -818,6 +1069,7 @@ private:
             activeWallpaper = "space";
             spaceBackgroundEnabled = true;
             backgroundColor = sf::Color::Black;
+            backgroundCache.markDirty();
             saveCoins();
         };
         shopButtons.push_back(toggleSpaceBgButton);
@@ -854,17 +1106,22 @@ private:
     }
 
     void handleEvents() {
-        std::optional<sf::Event> event;
-        while (event = window.pollEvent()) {
-            if (!event.has_value()) {
-                break;
-            }
-        if (event->is<sf::Event::Closed>()) {
+        ProfileScope scope("handleEvents");
+        while (const std::optional<sf::Event> event = window.pollEvent()) {
+            handleEvent(*event);
+        }
+    }
+
+    void handleEvent(const sf::Event& event) {
+        redrawNeeded = true;
+        if (event.is<sf::Event::Closed>()) {
             saveCoins();
             window.close();
-        } else if (const auto* resized = event->getIf<sf::Event::Resized>()) {
-            initializeMenus();
-        } else if (const auto* mouseButtonPressed = event->getIf<sf::Event::MouseButtonPressed>()) {
+        } else if (const auto* resized = event.getIf<sf::Event::Resized>()) {
+            if (gameState != GameState::Loading) {
+                initializeMenus();
+            }
+        } else if (const auto* mouseButtonPressed = event.getIf<sf::Event::MouseButtonPressed>()) {
             if (mouseButtonPressed->button == sf::Mouse::Button::Left) {
                 sf::Vector2i mousePos = sf::Mouse::getPosition(window);
                 sf::Vector2f mousePosF = static_cast<sf::Vector2f>(mousePos);
@@ -885,7 +1142,7 @@ private:
                             handledClick = true;
 
                             // Update music volume in real-time
-                            if (musicLoaded && slider.value == &soundVolume && tetrisMusic.has_value()) {
+                            if (musicLoaded && slider.value == &soundVolume && tetrisMusic) {
                                 tetrisMusic->setVolume(soundVolume * 100.0f);
                             }
                             break;
@@ -958,7 +1215,7 @@ private:
                     }
                 }
             }
-        } else if (const auto* mouseButtonReleased = event->getIf<sf::Event::MouseButtonReleased>()) {
+        } else if (const auto* mouseButtonReleased = event.getIf<sf::Event::MouseButtonReleased>()) {
             if (mouseButtonReleased->button == sf::Mouse::Button::Left) {
                 if (dragging && wobbleEnabled) {
                     // Start jello wobble effect
@@ -972,14 +1229,14 @@ private:
                     slider.isDragging = false;
                 }
             }
-        } else if (event->is<sf::Event::MouseMoved>()) {
+        } else if (event.is<sf::Event::MouseMoved>()) {
             sf::Vector2i mousePos = sf::Mouse::getPosition(window);
             sf::Vector2f mousePosF = static_cast<sf::Vector2f>(mousePos);
             if (gameState == GameState::Options) {
                 for (auto& slider : sliders) {
                     if (slider.isDragging) {
                         slider.updateValue(mousePosF);
-                        if (musicLoaded && slider.value == &soundVolume && tetrisMusic.has_value()) {
+                        if (musicLoaded && slider.value == &soundVolume && tetrisMusic) {
                             tetrisMusic->setVolume(soundVolume * 100.0f);
                         }
                     }
@@ -994,37 +1251,40 @@ private:
                 sf::Vector2i newPos(windowStartPos.x + deltaX + static_cast<int>(wobbleOffset), windowStartPos.y);
                 window.setPosition(newPos);
             }
-        } else if (const auto* keyPressed = event->getIf<sf::Event::KeyPressed>()) {
+        } else if (const auto* keyPressed = event.getIf<sf::Event::KeyPressed>()) {
+            // Profiler keys work on every screen
+            if (keyPressed->scancode == sf::Keyboard::Scancode::F3) {
+                profilerOverlay = !profilerOverlay;
+                profiler().setOverlay(profilerOverlay);
+                profilerRefresh.restart();
+                profilerText.reset();
+                return;
+            }
+            if (keyPressed->scancode == sf::Keyboard::Scancode::F4) {
+                if (profiler().traceRunning()) {
+                    stopTrace();
+                } else {
+                    profiler().startTrace();
+                    std::cout << "Recording trace, press F4 again to write " << options.tracePath << std::endl;
+                }
+                return;
+            }
             if (gameState == GameState::Game) {
                 switch (keyPressed->scancode) {
                     case sf::Keyboard::Scancode::Left:
-                        if (validPosition(currentPiece, -1, 0)) {
-                            currentPiece.x -= 1;
-                        }
+                        simulation.queueInput(Input::Left);
                         break;
                     case sf::Keyboard::Scancode::Right:
-                        if (validPosition(currentPiece, 1, 0)) {
-                            currentPiece.x += 1;
-                        }
+                        simulation.queueInput(Input::Right);
                         break;
-                    case sf::Keyboard::Scancode::Up: {
-                        int newRotation = (currentPiece.rotation + 1) % 4;
-                        if (validPosition(currentPiece, 0, 0, newRotation)) {
-                            currentPiece.rotation = newRotation;
-                        }
+                    case sf::Keyboard::Scancode::Up:
+                        simulation.queueInput(Input::Rotate);
                         break;
-                    }
                     case sf::Keyboard::Scancode::Down:
-                        if (validPosition(currentPiece, 0, 1)) {
-                            currentPiece.y += 1;
-                        }
+                        simulation.queueInput(Input::SoftDrop);
                         break;
                     case sf::Keyboard::Scancode::S:
-                        while (validPosition(currentPiece, 0, 1)) {
-                            currentPiece.y += 1;
-                        }
-                        placePiece();
-                        fallClock.restart();
+                        simulation.queueInput(Input::HardDrop);
                         break;
                     case sf::Keyboard::Scancode::R:
                         if (keyPressed->control) {
@@ -1041,10 +1301,10 @@ private:
             }
         }
     }
-    }
 
     void update() {
-        if (window.getSize() != currentWindowSize) {
+        ProfileScope scope("update");
+        if (window.getSize() != currentWindowSize && gameState != GameState::Loading) {
             initializeMenus();
             currentWindowSize = window.getSize();
         }
@@ -1072,7 +1332,8 @@ private:
         }
         
         // Handle music playback based on game state
-        if (musicLoaded && tetrisMusic.has_value()) {
+        if (musicLoaded && tetrisMusic) {
+            tetrisMusic->setTempo(themeTempoForLevel(snapshot.level));
             if ((gameState == GameState::Game || gameState == GameState::MainMenu) && tetrisMusic->getStatus() != sf::SoundSource::Status::Playing) {
                 tetrisMusic->play();
             } else if (gameState != GameState::Game && gameState != GameState::MainMenu && tetrisMusic->getStatus() == sf::SoundSource::Status::Playing) {
@@ -1080,203 +1341,347 @@ private:
             }
         }
 
-        if (fallClock.getElapsedTime().asMilliseconds() >= fallSpeed) {
-            if (gameState == GameState::Game) {
-                if (validPosition(currentPiece, 0, 1)) {
-                    currentPiece.y += 1;
-                } else {
-                    placePiece();
-                }
-            }
-            fallClock.restart();
-        }
+        syncSnapshot();
+        driveBot();
     }
 
-    void draw() {
-        // Draw titlebar
-        window.draw(titlebar);
-        window.draw(closeButton);
-        if (closeText.has_value()) window.draw(*closeText);
-        window.draw(minimizeButton);
-        if (minimizeText.has_value()) window.draw(*minimizeText);
+    // Every draw in a frame goes through here so draw calls can be counted
+    void render(sf::RenderTarget& target, const sf::Drawable& drawable) {
+        target.draw(drawable);
+        ++drawCalls;
+    }
 
-        // Set background color based on active wallpaper
+    void render(const sf::Drawable& drawable) {
+        render(window, drawable);
+    }
+
+    // Wallpaper or stars; only repainted when the background layer is marked dirty
+    void paintBackground(sf::RenderTarget& target) {
         if (activeWallpaper == "space" && spaceBackgroundEnabled) {
-            window.clear(sf::Color::Black);
-            // Draw space background stars
+            target.clear(sf::Color::Black);
             for (const auto& star : stars) {
                 sf::CircleShape starShape(1.f);
                 starShape.setPosition(star);
                 starShape.setFillColor(sf::Color::White);
-                window.draw(starShape);
+                render(target, starShape);
             }
         } else {
-            window.clear(backgroundColor);
+            target.clear(backgroundColor);
+        }
+    }
+
+    void paintBoard(sf::RenderTarget& target) {
+        drawCalls += boardLayer.draw(target);
+    }
+
+    void paintHud(sf::RenderTarget& target) {
+        // Removed boardBorder drawing to remove playing field border
+        // Keep scoreBorder to separate playing field from score
+        render(target, scoreBorder);
+
+        if (nextText.has_value()) render(target, *nextText);
+        if (scoreText.has_value()) render(target, *scoreText);
+        if (levelText.has_value()) render(target, *levelText);
+        if (linesText.has_value()) render(target, *linesText);
+        if (coinsText.has_value()) render(target, *coinsText);
+        if (backText.has_value()) render(target, *backText);
+    }
+
+    // Syncs the HUD texts with the game values; returns true if any text changed
+    bool refreshHud() {
+        bool changed = false;
+        if (scoreText.has_value()) changed |= scoreLabel.update(*scoreText, snapshot.score);
+        if (levelText.has_value()) changed |= levelLabel.update(*levelText, snapshot.level);
+        if (linesText.has_value()) changed |= linesLabel.update(*linesText, snapshot.linesCleared);
+        if (coinsText.has_value()) changed |= coinsLabel.update(*coinsText, coins);
+        return changed;
+    }
+
+    void markAllLayersDirty() {
+        backgroundCache.markDirty();
+        boardCache.markDirty();
+        hudCache.markDirty();
+    }
+
+    static sf::Vector2f cellPosition(int x, int y) {
+        return sf::Vector2f(x * CELL_SIZE, y * CELL_SIZE + TITLEBAR_HEIGHT);
+    }
+
+    // Everything that changes how a falling or preview piece looks
+    static uint64_t pieceKey(const Piece& piece, sf::Color color) {
+        uint64_t position = static_cast<uint8_t>(piece.x) | static_cast<uint64_t>(static_cast<uint16_t>(piece.y)) << 8 |
+                            static_cast<uint64_t>(piece.rotation) << 24 | static_cast<uint64_t>(shapeIndex(piece.shape)) << 26;
+        return static_cast<uint64_t>(color.toInteger()) << 32 | position;
+    }
+
+    // Slides the falling piece from where it was one tick ago toward where it is now
+    sf::Transform pieceInterpolation() const {
+        sf::Transform transform;
+        const Piece& previous = snapshot.previousPiece;
+        const Piece& current = snapshot.currentPiece;
+        if (snapshot.pieceContinues && previous.rotation == current.rotation) {
+            float remaining = 1.0f - simulation.interpolation();
+            transform.translate(sf::Vector2f((previous.x - current.x) * remaining * CELL_SIZE,
+                                             (previous.y - current.y) * remaining * CELL_SIZE));
+        }
+        return transform;
+    }
+
+    void recordFrameStats() {
+        statsFrames++;
+        statsDrawCalls += drawCalls;
+        statsMaxDrawCalls = std::max(statsMaxDrawCalls, drawCalls);
+        statsTextRebuilds += uiTextRebuilds;
+        if (profiler().enabled()) {
+            long long allocations = allocationCount();
+            profiler().endFrame((Profiler::nowUs() - frameStartUs) / 1000.0, drawCalls, allocations - frameAllocations);
+            frameAllocations = allocations;
+        }
+        drawCalls = 0;
+        uiTextRebuilds = 0;
+        if (options.renderStats && statsClock.getElapsedTime().asSeconds() >= 1.0f) {
+            std::cout << "draw calls/frame: avg " << static_cast<double>(statsDrawCalls) / statsFrames
+                      << ", max " << statsMaxDrawCalls << "; text rebuilds/frame: "
+                      << static_cast<double>(statsTextRebuilds) / statsFrames
+                      << " over " << statsFrames << " frames" << std::endl;
+            statsFrames = 0;
+            statsTextRebuilds = 0;
+            statsDrawCalls = 0;
+            statsMaxDrawCalls = 0;
+            statsClock.restart();
+        }
+    }
+
+    static const char* drawScopeName(GameState state) {
+        switch (state) {
+            case GameState::Loading: return "draw Loading";
+            case GameState::MainMenu: return "draw MainMenu";
+            case GameState::Options: return "draw Options";
+            case GameState::ModMenu: return "draw ModMenu";
+            case GameState::Keybinds: return "draw Keybinds";
+            case GameState::Game: return "draw Game";
+            case GameState::GameOver: return "draw GameOver";
+            case GameState::Shop: return "draw Shop";
+        }
+        return "draw";
+    }
+
+    void stopTrace() {
+        if (profiler().stopTrace(options.tracePath)) {
+            std::cout << "Trace written to " << options.tracePath << std::endl;
+        } else {
+            std::cerr << "Failed to write trace " << options.tracePath << std::endl;
         }
+    }
+
+    // Frame-time percentiles, draw calls, allocations and the slowest phases, top left over everything
+    void drawProfilerOverlay() {
+        if (gameState == GameState::Loading) {
+            return; // no font yet
+        }
+        if (!profilerText.has_value() || profilerRefresh.getElapsedTime().asSeconds() >= 0.5f) {
+            profilerRefresh.restart();
+            FrameSummary summary = profiler().summarize();
+            std::ostringstream text;
+            text << std::fixed << std::setprecision(2);
+            text << "frame ms  p50 " << summary.p50Ms << "  p95 " << summary.p95Ms << "  p99 " << summary.p99Ms
+                 << "  max " << summary.maxMs << "\n";
+            text << std::setprecision(1) << "draw calls " << summary.drawCalls << "  allocs " << summary.allocations
+                 << "  (" << summary.frames << " frames)\n";
+            text << std::setprecision(3);
+            for (size_t i = 0; i < summary.phaseMs.size() && i < 8; ++i) {
+                text << summary.phaseMs[i].first << "  " << summary.phaseMs[i].second << " ms\n";
+            }
+            if (profiler().traceRunning()) {
+                text << "recording trace (F4 to stop)\n";
+            }
+            profilerText = sf::Text(font, text.str(), 12);
+            profilerText->setFillColor(sf::Color::White);
+            profilerText->setPosition(sf::Vector2f(8.f, TITLEBAR_HEIGHT + 6.f));
+            sf::FloatRect bounds = profilerText->getGlobalBounds();
+            profilerPanel.setSize(sf::Vector2f(bounds.size.x + 12.f, bounds.size.y + 12.f));
+            profilerPanel.setPosition(sf::Vector2f(2.f, TITLEBAR_HEIGHT + 2.f));
+            profilerPanel.setFillColor(sf::Color(0, 0, 0, 180));
+        }
+        render(profilerPanel);
+        render(*profilerText);
+    }
+
+    void draw() {
+        ProfileScope scope("draw");
+        // Draw titlebar
+        render(titlebar);
+        render(closeButton);
+        if (closeText.has_value()) render(*closeText);
+        render(minimizeButton);
+        if (minimizeText.has_value()) render(*minimizeText);
+
+        // Static layers come from their render textures unless marked dirty
+        window.clear(sf::Color::Black);
+        drawCalls += backgroundCache.draw(window, [this](sf::RenderTarget& target) { paintBackground(target); });
 
+        ProfileScope stateScope(drawScopeName(gameState));
         switch (gameState) {
+            case GameState::Loading:
+                break; // only the background until the assets are in
             case GameState::MainMenu:
-                if (titleText.has_value()) window.draw(*titleText);
-                if (subtitleText.has_value()) window.draw(*subtitleText);
+                if (titleText.has_value()) render(*titleText);
+                if (subtitleText.has_value()) render(*subtitleText);
                 for (auto& button : mainButtons) {
-                    window.draw(button.rect);
-                    window.draw(button.text);
+                    render(button.rect);
+                    render(button.text);
                 }
                 if (mainMenuCoinsText.has_value()) {
-                    mainMenuCoinsText->setString("$ " + std::to_string(coins));
-                    window.draw(*mainMenuCoinsText);
+                    mainMenuCoinsLabel.update(*mainMenuCoinsText, coins);
+                    render(*mainMenuCoinsText);
                 }
                 break;
             case GameState::Options:
                 // Draw sliders
                 for (auto& slider : sliders) {
-                    // Update slider labels with current values
-                    if (slider.value == &brightness) {
-                        slider.label.setString("Brightness: " + std::to_string(static_cast<int>(brightness * 100)) + "%");
-                    } else if (slider.value == &soundVolume) {
-                        slider.label.setString("Volume: " + std::to_string(static_cast<int>(soundVolume * 100)) + "%");
-                    } else if (slider.value == &rainbowSpeed) {
-                        slider.label.setString("Rainbow Speed: " + std::to_string(static_cast<int>(rainbowSpeed * 100)) + "%");
-                    }
+                    slider.refreshLabel();
                     slider.updateHandle();
-                    window.draw(slider.track);
-                    window.draw(slider.handle);
-                    window.draw(slider.label);
+                    render(slider.track);
+                    render(slider.handle);
+                    render(slider.label);
                 }
                 
                 // Draw other option buttons
                 for (auto& button : optionsButtons) {
-                    if (button.text.getString().find("Window Wobble") != std::string::npos) {
-                        button.text.setString(wobbleEnabled ? "Window Wobble: On" : "Window Wobble: Off");
-                    }
-                    window.draw(button.rect);
-                    window.draw(button.text);
+                    button.refresh();
+                    render(button.rect);
+                    render(button.text);
                 }
                 break;
             case GameState::ModMenu:
                 for (auto& button : modButtons) {
-                    if (button.text.getString().find("Rainbow Mode") != std::string::npos) {
-                        button.text.setString(modRainbow ? "Rainbow Mode: On" : "Rainbow Mode: Off");
-                    }
-                    window.draw(button.rect);
-                    window.draw(button.text);
+                    button.refresh();
+                    render(button.rect);
+                    render(button.text);
                 }
                 break;
             case GameState::Shop:
                 for (auto& button : shopButtons) {
-                    window.draw(button.rect);
-                    window.draw(button.text);
+                    render(button.rect);
+                    render(button.text);
                 }
                 break;
             case GameState::Game: {
-                // Draw borders
-                // Removed boardBorder drawing to remove playing field border
-                // Keep scoreBorder to separate playing field from score
-                sf::RectangleShape scoreBorder(sf::Vector2f(WINDOW_WIDTH - BOARD_WIDTH * CELL_SIZE - 2, WINDOW_HEIGHT - TITLEBAR_HEIGHT - 2));
-                scoreBorder.setPosition(sf::Vector2f(BOARD_WIDTH * CELL_SIZE + 1, TITLEBAR_HEIGHT - 1));
-                scoreBorder.setFillColor(sf::Color::Transparent);
-                scoreBorder.setOutlineColor(sf::Color::White);
-                scoreBorder.setOutlineThickness(1);
-                window.draw(scoreBorder);
-
-                // Draw board
-                for (int y = 0; y < BOARD_HEIGHT; ++y) {
-                    for (int x = 0; x < BOARD_WIDTH; ++x) {
-                        if (board[y][x] != sf::Color::Black) {
-                            sf::RectangleShape cell(sf::Vector2f(CELL_SIZE - 1, CELL_SIZE - 1));
-                            cell.setPosition(sf::Vector2f(x * CELL_SIZE, y * CELL_SIZE + TITLEBAR_HEIGHT));
-                            sf::Color adjusted = board[y][x];
-                            adjusted.r = static_cast<uint8_t>(std::min(255.0f, adjusted.r * brightness));
-                            adjusted.g = static_cast<uint8_t>(std::min(255.0f, adjusted.g * brightness));
-                            adjusted.b = static_cast<uint8_t>(std::min(255.0f, adjusted.b * brightness));
-                            cell.setFillColor(adjusted);
-                            window.draw(cell);
-                        }
-                    }
-                }
-                // Draw current piece
-                ShapeMatrix matrix = getShapeMatrix(currentPiece);
-                sf::Color pieceColor = currentPiece.color;
-                if (modRainbow) {
-                    pieceColor = getRainbowColor();
-                }
-                sf::Color adjustedPiece = pieceColor;
-                adjustedPiece.r = static_cast<uint8_t>(std::min(255.0f, adjustedPiece.r * brightness));
-                adjustedPiece.g = static_cast<uint8_t>(std::min(255.0f, adjustedPiece.g * brightness));
-                adjustedPiece.b = static_cast<uint8_t>(std::min(255.0f, adjustedPiece.b * brightness));
-                for (int y = 0; y < (int)matrix.size(); ++y) {
-                    for (int x = 0; x < (int)matrix[y].size(); ++x) {
-                        if (matrix[y][x]) {
-                            sf::RectangleShape cell(sf::Vector2f(CELL_SIZE - 1, CELL_SIZE - 1));
-                            cell.setPosition(sf::Vector2f((currentPiece.x + x) * CELL_SIZE, (currentPiece.y + y) * CELL_SIZE + TITLEBAR_HEIGHT));
-                            cell.setFillColor(adjustedPiece);
-                            window.draw(cell);
+                // Board, piece and preview are one vertex array each, rebuilt only when their content changes.
+                // Locked cells are cached, so only the falling piece and preview are drawn every frame.
+                if (boardLayer.changed(snapshot.boardRevision, floatBits(brightness))) {
+                    boardLayer.clear();
+                    for (int y = 0; y < GameBoard::HEIGHT; ++y) {
+                        for (int x = 0; x < GameBoard::WIDTH; ++x) {
+                            if (snapshot.board.filled(x, y)) {
+                                boardLayer.addCell(cellPosition(x, y), CELL_SIZE - CELL_GAP, applyBrightness(sf::Color(snapshot.board.cell(x, y)), brightness));
+                            }
                         }
                     }
+                    boardCache.markDirty();
                 }
-                // Draw next piece
-                sf::Text nextText(font, "Next:", 24);
-                nextText.setFillColor(sf::Color::White);
-                nextText.setPosition(sf::Vector2f(BOARD_WIDTH * CELL_SIZE + 10, 200 + TITLEBAR_HEIGHT));
-                window.draw(nextText);
-
-                ShapeMatrix nextMatrix = getShapeMatrix(nextPiece);
-                sf::Color nextColor = nextPiece.color;
-                if (modRainbow) {
-                    nextColor = getRainbowColor();
+                drawCalls += boardCache.draw(window, [this](sf::RenderTarget& target) { paintBoard(target); });
+                if (refreshHud()) {
+                    hudCache.markDirty();
                 }
-                for (int y = 0; y < (int)nextMatrix.size(); ++y) {
-                    for (int x = 0; x < (int)nextMatrix[y].size(); ++x) {
-                        if (nextMatrix[y][x]) {
-                            sf::RectangleShape cell(sf::Vector2f(CELL_SIZE - 1, CELL_SIZE - 1));
-                            cell.setPosition(sf::Vector2f(BOARD_WIDTH * CELL_SIZE + 50 + x * CELL_SIZE, 230 + y * CELL_SIZE + TITLEBAR_HEIGHT));
-                            cell.setFillColor(nextColor);
-                            window.draw(cell);
-                        }
+                drawCalls += hudCache.draw(window, [this](sf::RenderTarget& target) { paintHud(target); });
+
+                const Piece& currentPiece = snapshot.currentPiece;
+                sf::Color pieceColor = modRainbow ? getRainbowColor() : sf::Color(currentPiece.color);
+
+                // Ghost: the falling piece's outline where a hard drop would put it. The engine only
+                // recomputes the landing row when the piece moves sideways or turns.
+                Piece ghost = currentPiece;
+                ghost.y = snapshot.ghostY;
+                if (ghostLayer.changed(pieceKey(ghost, pieceColor), floatBits(brightness))) {
+                    ghostLayer.clear();
+                    sf::Color ghostColor = applyBrightness(pieceColor, brightness);
+                    ghostColor.a = 70;
+                    for (const Cell& c : shapeRotation(ghost.shape, ghost.rotation).cells) {
+                        ghostLayer.addCell(cellPosition(ghost.x + c.x, ghost.y + c.y), CELL_SIZE - CELL_GAP, ghostColor);
                     }
                 }
+                drawCalls += ghostLayer.draw(window);
 
-                // Draw UI
-                if (scoreText.has_value()) {
-                    scoreText->setString("Score: " + std::to_string(score));
-                    window.draw(*scoreText);
-                }
-                if (levelText.has_value()) {
-                    levelText->setString("Level: " + std::to_string(level));
-                    window.draw(*levelText);
-                }
-                if (linesText.has_value()) {
-                    linesText->setString("Lines: " + std::to_string(linesCleared));
-                    window.draw(*linesText);
+                if (pieceLayer.changed(pieceKey(currentPiece, pieceColor), floatBits(brightness))) {
+                    pieceLayer.clear();
+                    sf::Color adjustedPiece = applyBrightness(pieceColor, brightness);
+                    for (const Cell& c : shapeRotation(currentPiece.shape, currentPiece.rotation).cells) {
+                        pieceLayer.addCell(cellPosition(currentPiece.x + c.x, currentPiece.y + c.y), CELL_SIZE - CELL_GAP, adjustedPiece);
+                    }
                 }
-                if (coinsText.has_value()) {
-                    coinsText->setString("$ " + std::to_string(coins));
-                    window.draw(*coinsText);
+                drawCalls += pieceLayer.draw(window, sf::RenderStates(pieceInterpolation()));
+
+                const Piece& nextPiece = snapshot.nextPiece;
+                sf::Color nextColor = modRainbow ? getRainbowColor() : sf::Color(nextPiece.color);
+                if (previewLayer.changed(pieceKey(nextPiece, nextColor), 0)) {
+                    previewLayer.clear();
+                    for (const Cell& c : shapeRotation(nextPiece.shape, nextPiece.rotation).cells) {
+                        previewLayer.addCell(sf::Vector2f(PLAYFIELD_WIDTH + 50 + c.x * PREVIEW_CELL_SIZE, 230 + c.y * PREVIEW_CELL_SIZE + TITLEBAR_HEIGHT),
+                                             PREVIEW_CELL_SIZE - 1, nextColor);
+                    }
                 }
-                if (backText.has_value()) window.draw(*backText);
+                drawCalls += previewLayer.draw(window);
             break;
             }
             case GameState::GameOver:
-                if (titleText.has_value()) window.draw(*titleText);
-                if (subtitleText.has_value()) window.draw(*subtitleText);
-                sf::Text gameOverText(font, "Game Over", 48);
-                gameOverText.setFillColor(sf::Color::Red);
-                gameOverText.setPosition(sf::Vector2f(WINDOW_WIDTH / 2 - 120.f, 150.f + TITLEBAR_HEIGHT));
-                window.draw(gameOverText);
+                if (titleText.has_value()) render(*titleText);
+                if (subtitleText.has_value()) render(*subtitleText);
+                if (gameOverText.has_value()) render(*gameOverText);
                 for (auto& button : gameOverButtons) {
-                    window.draw(button.rect);
-                    window.draw(button.text);
+                    render(button.rect);
+                    render(button.text);
                 }
                 break;
 
 }
+    if (profilerOverlay) {
+        drawProfilerOverlay();
+    }
     window.display();
+    recordFrameStats();
 }
 };
 
-int main() {
-    TetrisApp app;
-    app.run();
+// The engine benchmarks plus one offscreen draw() frame of a running game
+inline int runAppBenchmarks(int argc, char** argv) {
+    std::vector<BenchmarkCase> cases = engineBenchmarks();
+    AppOptions options;
+    options.benchmark = true;
+    options.fixedSeed = true;
+    std::unique_ptr<TetrisApp> app;
+    cases.push_back({"drawFrame", "macro", 2000, [&](long long n) {
+        if (!app) app = std::make_unique<TetrisApp>(options);
+        return app->benchmarkFrames(n);
+    }});
+    return runBenchmarkSuite(argc, argv, cases);
+}
+
+int main(int argc, char** argv) {
+#ifdef BENCHMARK_MAIN
+    return runAppBenchmarks(argc, argv);
+#endif
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--headless") {
+            return runHeadless(argc, argv);
+        }
+        if (std::string(argv[i]) == "--bench-suite") {
+            return runAppBenchmarks(argc, argv);
+        }
+        if (std::string(argv[i]) == "--alloc-check") {
+            AllocationCheckOptions check = parseAllocationCheckOptions(argc, argv);
+            AppOptions options = parseAppOptions(argc, argv);
+            options.benchmark = true;
+            options.fixedSeed = true;
+            options.seed = check.seed;
+            auto app = std::make_unique<TetrisApp>(options);
+            return app->allocationCheck(check) ? 0 : 1;
+        }
+    }
+
+    // On the heap: a large compiled-in board makes the app too big for the stack
+    auto app = std::make_unique<TetrisApp>(parseAppOptions(argc, argv));
+    app->run();
     return 0;
 }
 
@@ -0,0 +1,34 @@
+// Process-level measurements that don't need SFML
+#pragma once
+
+#include <chrono>
+#include <ctime>
+
+// Process CPU time (all threads) spent per minute of wall time
+class CpuMeter {
+public:
+    CpuMeter() { restart(); }
+
+    void restart() {
+        wallStart = std::chrono::steady_clock::now();
+        cpuStart = std::clock();
+    }
+
+    double wallSeconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    }
+
+    double cpuSeconds() const {
+        return static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    }
+
+    // CPU seconds per wall-clock minute since the last restart
+    double cpuSecondsPerMinute() const {
+        double wall = wallSeconds();
+        return wall > 0 ? cpuSeconds() * 60.0 / wall : 0.0;
+    }
+
+private:
+    std::chrono::steady_clock::time_point wallStart;
+    std::clock_t cpuStart;
+};
@@ -0,0 +1,193 @@
+// Reachable-placement move generator: searches (rotation, x, y) from the piece's current
+// position using the game's own moves (Left, Right, Rotate, SoftDrop), so tucks and spins
+// under overhangs are found. Every reachable resting state is a lock position.
+#pragma once
+
+#include "engine.hpp"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Where a piece ends up: rotation, top-left corner column and row
+struct Placement {
+    int rotation = 0;
+    int x = 0;
+    int y = 0;
+    bool valid = false;
+};
+
+// The lowest rotation index with the same cells, so O has one orientation and I, S, Z have two
+constexpr std::array<std::array<int, 4>, SHAPE_COUNT> buildCanonicalRotations() {
+    std::array<std::array<int, 4>, SHAPE_COUNT> table{};
+    for (int s = 0; s < SHAPE_COUNT; ++s) {
+        for (int rot = 0; rot < 4; ++rot) {
+            table[s][rot] = rot;
+            for (int other = rot - 1; other >= 0; --other) {
+                const ShapeRotation& a = ROTATIONS[s][rot];
+                const ShapeRotation& b = ROTATIONS[s][other];
+                if (a.height == b.height && a.rows[0] == b.rows[0] && a.rows[1] == b.rows[1] &&
+                    a.rows[2] == b.rows[2] && a.rows[3] == b.rows[3]) {
+                    table[s][rot] = other;
+                }
+            }
+        }
+    }
+    return table;
+}
+
+constexpr std::array<std::array<int, 4>, SHAPE_COUNT> CANONICAL_ROTATIONS = buildCanonicalRotations();
+
+static_assert(CANONICAL_ROTATIONS[3][3] == 0, "O looks the same every way round");
+static_assert(CANONICAL_ROTATIONS[0][2] == 0 && CANONICAL_ROTATIONS[0][3] == 1, "I has two orientations");
+
+// Finds every lock position with bitboard flood fills. For each rotation and row, one 16-bit
+// mask holds the columns where the piece fits and another the columns it can reach; sideways
+// moves, soft drops and rotations are shifts and ANDs on whole rows at once. Reached states are
+// stored in those masks directly, a perfect hash of (rotation, x, y) at one bit per state.
+class MoveGenerator {
+public:
+    static_assert(BOARD_WIDTH <= 16 && BOARD_HEIGHT <= 32, "state packing assumes x < 16 and y < 32");
+
+    // Calls visit(placement) once for every distinct lock position; returns how many there were
+    template<class Visit>
+    int generate(const BoardRows& rows, const Piece& piece, Visit visit) {
+        board = rows;
+        origin = piece;
+        generations++;
+        const int s = shapeIndex(piece.shape);
+        for (int rot = 0; rot < 4; ++rot) {
+            fitMasks(ROTATIONS[s][rot], fit[rot]);
+        }
+        std::memset(reach, 0, sizeof(reach));
+        if (!((fit[piece.rotation][piece.y] >> piece.x) & 1u)) {
+            return 0;
+        }
+        reach[piece.rotation][piece.y] = static_cast<RowMask>(1u << piece.x);
+
+        // Flood until nothing new is reached; soft drops only go down, so rows are swept top to bottom
+        bool grew = true;
+        while (grew) {
+            grew = false;
+            for (int y = 0; y < BOARD_HEIGHT; ++y) {
+                for (int rot = 0; rot < 4; ++rot) {
+                    RowMask r = reach[rot][y];
+                    if (!r) continue;
+                    RowMask spread = r;
+                    do {
+                        r = spread;
+                        spread = (r | r << 1 | r >> 1) & fit[rot][y];
+                    } while (spread != r);
+                    int nextRot = (rot + 1) % 4;
+                    RowMask rotated = reach[nextRot][y] | (r & fit[nextRot][y]);
+                    if (rotated != reach[nextRot][y]) {
+                        reach[nextRot][y] = rotated;
+                        grew |= nextRot < rot; // an earlier rotation of this row has to be swept again
+                    }
+                    reach[rot][y] = r;
+                    if (y + 1 < BOARD_HEIGHT) {
+                        reach[rot][y + 1] |= r & fit[rot][y + 1];
+                    }
+                }
+            }
+        }
+
+        // Resting states lock; rotations with identical cells share their lock positions
+        const std::array<int, 4>& canonical = CANONICAL_ROTATIONS[s];
+        int found = 0;
+        for (int y = 0; y < BOARD_HEIGHT; ++y) {
+            RowMask seen[4] = {};
+            for (int rot = 0; rot < 4; ++rot) {
+                RowMask resting = reach[rot][y] & ~(y + 1 < BOARD_HEIGHT ? fit[rot][y + 1] : 0);
+                resting &= ~seen[canonical[rot]];
+                seen[canonical[rot]] |= resting;
+                for (; resting; resting &= resting - 1) {
+                    int x = lowestBit(resting);
+                    found++;
+                    visit(Placement{rot, x, y, true});
+                }
+            }
+        }
+        return found;
+    }
+
+    // Inputs from the piece given to the last generate() to the placement, ending in a hard drop.
+    // Only the chosen placement needs a path, so this is a plain BFS with parent links.
+    std::vector<Input> pathTo(const Placement& placement) {
+        std::vector<Input> path;
+        if (!((reach[placement.rotation][placement.y] >> placement.x) & 1u)) {
+            return path;
+        }
+        std::memset(visited, 0, sizeof(visited));
+        int head = 0, tail = 0;
+        uint16_t start = pack(origin.rotation, origin.x, origin.y);
+        uint16_t goal = pack(placement.rotation, placement.x, placement.y);
+        visited[start] = 1;
+        parent[start] = start;
+        queue[tail++] = start;
+        while (head < tail && !visited[goal]) {
+            uint16_t state = queue[head++];
+            int rot = state >> 9, y = (state >> 4) & 31, x = state & 15;
+            // The same moves TetrisEngine::apply makes
+            const int moves[4][3] = {{rot, x - 1, y}, {rot, x + 1, y}, {(rot + 1) % 4, x, y}, {rot, x, y + 1}};
+            for (int m = 0; m < 4; ++m) {
+                int mr = moves[m][0], mx = moves[m][1], my = moves[m][2];
+                if (mx < 0 || my >= BOARD_HEIGHT || !((fit[mr][my] >> mx) & 1u)) continue;
+                uint16_t next = pack(mr, mx, my);
+                if (visited[next]) continue;
+                visited[next] = 1;
+                parent[next] = state;
+                move[next] = static_cast<uint8_t>(MOVE_INPUTS[m]);
+                queue[tail++] = next;
+            }
+        }
+        for (uint16_t state = goal; parent[state] != state; state = parent[state]) {
+            path.push_back(static_cast<Input>(move[state]));
+        }
+        std::reverse(path.begin(), path.end());
+        path.push_back(Input::HardDrop);
+        return path;
+    }
+
+    // generate() calls since construction
+    long long generations = 0;
+
+private:
+    static constexpr Input MOVE_INPUTS[4] = {Input::Left, Input::Right, Input::Rotate, Input::SoftDrop};
+    static const int STATE_COUNT = 1 << 11; // (rotation, y, x) in 2 + 5 + 4 bits
+
+    BoardRows board{};
+    Piece origin{};
+    RowMask fit[4][BOARD_HEIGHT];
+    RowMask reach[4][BOARD_HEIGHT];
+    uint8_t visited[STATE_COUNT];
+    uint16_t queue[STATE_COUNT];
+    uint16_t parent[STATE_COUNT];
+    uint8_t move[STATE_COUNT];
+
+    static uint16_t pack(int rotation, int x, int y) {
+        return static_cast<uint16_t>(rotation << 9 | y << 4 | x);
+    }
+
+    static int lowestBit(RowMask mask) {
+        int x = 0;
+        while (!((mask >> x) & 1u)) ++x;
+        return x;
+    }
+
+    // out[y] bit x is set when the rotation fits with its top-left corner at (x, y).
+    // A cell at offset (cx, cy) is blocked at x wherever row y + cy has a block at x + cx.
+    void fitMasks(const ShapeRotation& r, RowMask* out) const {
+        const RowMask inside = static_cast<RowMask>((1u << (BOARD_WIDTH - r.width + 1)) - 1);
+        for (int y = 0; y < BOARD_HEIGHT; ++y) {
+            if (y + r.height > BOARD_HEIGHT) {
+                out[y] = 0;
+                continue;
+            }
+            RowMask blocked = 0;
+            for (const Cell& c : r.cells) {
+                blocked |= board[y + c.y] >> c.x;
+            }
+            out[y] = inside & ~blocked;
+        }
+    }
+};
@@ -0,0 +1,38 @@
+// Streams the synthesized theme to SFML audio, generating chunks on the audio thread
+#pragma once
+
+#include "synth.hpp"
+#include <SFML/Audio.hpp>
+#include <array>
+
+class ThemeStream : public sf::SoundStream {
+public:
+    static const size_t CHUNK_SAMPLES = 4096; // ~93 ms, also the latency of a tempo change
+
+    ThemeStream() {
+        initialize(1, SAMPLE_RATE, {sf::SoundChannel::Mono});
+    }
+
+    ~ThemeStream() override {
+        stop(); // the audio thread must be done with onGetData before members go away
+    }
+
+    void setTempo(float multiplier) { synth.setTempo(multiplier); }
+
+protected:
+    // The melody loops forever, so there is always another chunk
+    bool onGetData(Chunk& data) override {
+        synth.render(buffer.data(), buffer.size());
+        data.samples = buffer.data();
+        data.sampleCount = buffer.size();
+        return true;
+    }
+
+    void onSeek(sf::Time) override {
+        synth.restart();
+    }
+
+private:
+    ThemeSynth synth;
+    std::array<int16_t, CHUNK_SAMPLES> buffer{};
+};
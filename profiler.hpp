@@ -0,0 +1,186 @@
+// Frame-phase profiler: scoped timers for the main loop phases and hot engine calls,
+// rolling frame-time percentiles for the overlay, and Chrome trace-event export
+// (open the file in chrome://tracing or https://ui.perfetto.dev).
+// A scope costs one relaxed load while neither the overlay nor a trace is on.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct TraceEvent {
+    const char* name; // string literal, compared by address
+    uint32_t thread;
+    int64_t startUs;
+    int64_t durationUs;
+};
+
+// Phase times per frame, frame-time percentiles and draw calls/allocations over the last frames
+struct FrameSummary {
+    int frames = 0;
+    double p50Ms = 0, p95Ms = 0, p99Ms = 0, maxMs = 0;
+    double drawCalls = 0;
+    double allocations = 0;
+    std::vector<std::pair<const char*, double>> phaseMs; // average per frame, slowest first
+};
+
+// Set while the overlay or a trace wants samples; a plain global so a disabled scope is one load, no static guard
+inline std::atomic<bool> profilerActive{false};
+
+class Profiler {
+public:
+    static const int HISTORY_FRAMES = 240;
+    static const size_t MAX_TRACE_EVENTS = 1000000; // about 24 MB; later events are dropped
+
+    bool enabled() const { return profilerActive.load(std::memory_order_relaxed); }
+
+    // The overlay and tracing each keep the profiler running
+    void setOverlay(bool on) {
+        overlay = on;
+        profilerActive = overlay || tracing;
+    }
+
+    void startTrace() {
+        std::lock_guard<std::mutex> lock(mutex);
+        events.clear();
+        tracing = true;
+        profilerActive = true;
+    }
+
+    bool traceRunning() const { return tracing; }
+
+    // Stops recording and writes the events as Chrome trace JSON ("X" complete events)
+    bool stopTrace(const std::string& path) {
+        std::vector<TraceEvent> recorded;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tracing = false;
+            profilerActive = overlay;
+            recorded.swap(events);
+        }
+        std::ofstream file(path, std::ios::trunc);
+        file << "{\"traceEvents\":[\n";
+        for (size_t i = 0; i < recorded.size(); ++i) {
+            const TraceEvent& e = recorded[i];
+            file << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread << ",\"ts\":" << e.startUs
+                 << ",\"dur\":" << e.durationUs << "}" << (i + 1 < recorded.size() ? ",\n" : "\n");
+        }
+        file << "],\"displayTimeUnit\":\"ms\"}\n";
+        return static_cast<bool>(file.flush());
+    }
+
+    static int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - EPOCH).count();
+    }
+
+    void record(const char* name, int64_t startUs, int64_t endUs) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tracing && events.size() < MAX_TRACE_EVENTS) {
+            events.push_back({name, threadNumber(), startUs, endUs - startUs});
+        }
+        for (auto& phase : phaseTotals) {
+            if (phase.first == name) {
+                phase.second += endUs - startUs;
+                return;
+            }
+        }
+        phaseTotals.push_back({name, endUs - startUs});
+    }
+
+    // Called once per drawn frame with the frame's work time (idle waits excluded)
+    void endFrame(double frameMs, int drawCalls, long long allocations) {
+        std::lock_guard<std::mutex> lock(mutex);
+        FrameSample& sample = history[frameCount % HISTORY_FRAMES];
+        sample = {frameMs, drawCalls, allocations};
+        frameCount++;
+        summaryFrames++;
+    }
+
+    // Summary of the frames since the last call; phase averages cover the same frames
+    FrameSummary summarize() {
+        std::lock_guard<std::mutex> lock(mutex);
+        FrameSummary summary;
+        int count = static_cast<int>(std::min<long long>(frameCount, HISTORY_FRAMES));
+        if (count == 0) return summary;
+        std::vector<double> times;
+        times.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            times.push_back(history[i].frameMs);
+            summary.drawCalls += history[i].drawCalls;
+            summary.allocations += static_cast<double>(history[i].allocations);
+        }
+        std::sort(times.begin(), times.end());
+        auto percentile = [&](double p) { return times[std::min(count - 1, static_cast<int>(p * count))]; };
+        summary.frames = count;
+        summary.p50Ms = percentile(0.50);
+        summary.p95Ms = percentile(0.95);
+        summary.p99Ms = percentile(0.99);
+        summary.maxMs = times.back();
+        summary.drawCalls /= count;
+        summary.allocations /= count;
+        for (auto& phase : phaseTotals) {
+            summary.phaseMs.push_back({phase.first, phase.second / 1000.0 / std::max<long long>(1, summaryFrames)});
+            phase.second = 0;
+        }
+        summaryFrames = 0;
+        std::sort(summary.phaseMs.begin(), summary.phaseMs.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+        return summary;
+    }
+
+private:
+    struct FrameSample {
+        double frameMs;
+        int drawCalls;
+        long long allocations;
+    };
+
+    inline static const std::chrono::steady_clock::time_point EPOCH = std::chrono::steady_clock::now();
+
+    bool overlay = false;
+    bool tracing = false;
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    std::vector<std::pair<const char*, int64_t>> phaseTotals; // microseconds since the last summary
+    FrameSample history[HISTORY_FRAMES] = {};
+    long long frameCount = 0;
+    long long summaryFrames = 0;
+
+    // Small stable ids for the trace's tid column
+    static uint32_t threadNumber() {
+        static std::atomic<uint32_t> next{1};
+        thread_local uint32_t id = next++;
+        return id;
+    }
+};
+
+inline Profiler& profiler() {
+    static Profiler instance;
+    return instance;
+}
+
+// Times the enclosing block under `name`, which must be a string literal
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* scopeName)
+        : name(profilerActive.load(std::memory_order_relaxed) ? scopeName : nullptr) {
+        if (name) start = Profiler::nowUs();
+    }
+
+    ~ProfileScope() {
+        if (name) profiler().record(name, start, Profiler::nowUs());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    int64_t start = 0;
+};
@@ -0,0 +1,107 @@
+// Batched cell rendering: each layer of grid cells is one vertex array and one draw call
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+
+inline sf::Color applyBrightness(sf::Color color, float brightness) {
+    color.r = static_cast<uint8_t>(std::min(255.0f, color.r * brightness));
+    color.g = static_cast<uint8_t>(std::min(255.0f, color.g * brightness));
+    color.b = static_cast<uint8_t>(std::min(255.0f, color.b * brightness));
+    return color;
+}
+
+inline uint32_t floatBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+class CellLayer {
+public:
+    // Returns true when the content key differs from the one the vertices were built for.
+    // The caller then rebuilds with clear() and addCell().
+    bool changed(uint64_t keyA, uint64_t keyB) {
+        if (built && keyA == lastKeyA && keyB == lastKeyB) {
+            return false;
+        }
+        built = true;
+        lastKeyA = keyA;
+        lastKeyB = keyB;
+        return true;
+    }
+
+    void invalidate() { built = false; }
+
+    void clear() { vertices.clear(); }
+
+    // Two triangles per cell since SFML 3 has no quads
+    void addCell(sf::Vector2f position, float size, sf::Color color) {
+        sf::Vector2f topRight(position.x + size, position.y);
+        sf::Vector2f bottomLeft(position.x, position.y + size);
+        sf::Vector2f bottomRight(position.x + size, position.y + size);
+        vertices.append(sf::Vertex{position, color});
+        vertices.append(sf::Vertex{topRight, color});
+        vertices.append(sf::Vertex{bottomLeft, color});
+        vertices.append(sf::Vertex{bottomLeft, color});
+        vertices.append(sf::Vertex{topRight, color});
+        vertices.append(sf::Vertex{bottomRight, color});
+    }
+
+    // Returns the number of draw calls issued (0 for an empty layer)
+    int draw(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default) const {
+        if (vertices.getVertexCount() == 0) {
+            return 0;
+        }
+        target.draw(vertices, states);
+        return 1;
+    }
+
+private:
+    sf::VertexArray vertices{sf::PrimitiveType::Triangles};
+    bool built = false;
+    uint64_t lastKeyA = 0;
+    uint64_t lastKeyB = 0;
+};
+
+// A window-sized layer kept in a render texture and repainted only after markDirty().
+// Falls back to painting straight into the target when render textures are unavailable.
+class CachedLayer {
+public:
+    void resize(sf::Vector2u size) {
+        ready = texture.resize(size);
+        if (ready) {
+            sprite.emplace(texture.getTexture());
+        }
+        dirty = true;
+    }
+
+    void markDirty() { dirty = true; }
+
+    // paint(target) draws the layer content and counts its own draw calls.
+    // Returns the draw calls spent compositing the cached texture.
+    template<class Paint>
+    int draw(sf::RenderTarget& target, Paint paint) {
+        if (!ready) {
+            paint(target);
+            return 0;
+        }
+        if (dirty) {
+            texture.clear(sf::Color::Transparent);
+            paint(texture);
+            texture.display();
+            dirty = false;
+        }
+        target.draw(*sprite);
+        return 1;
+    }
+
+private:
+    sf::RenderTexture texture;
+    std::optional<sf::Sprite> sprite;
+    bool ready = false;
+    bool dirty = true;
+};
@@ -0,0 +1,304 @@
+// Deterministic replays: the seed plus every input and the tick it was applied on.
+// Played back through the same per-tick order as Simulation::step, a replay reproduces the game exactly.
+#pragma once
+
+#include "binio.hpp"
+#include "engine.hpp"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ReplayEvent {
+    uint64_t tick; // game tick the input was applied on, before that tick's gravity
+    Input input;
+};
+
+struct Replay {
+    uint32_t seed = 0;
+    int tickRate = 60;
+    std::vector<ReplayEvent> events;
+    uint64_t endTick = 0; // ticks the recorded game ran for
+    // Result claimed by the recorder, checked on playback
+    int score = 0;
+    int linesCleared = 0;
+    int level = 1;
+};
+
+// Layout, all fixed-width integers little-endian:
+//   "TRPL" | u32 version | u32 seed | u32 tick rate | u32 event count
+//   events: varint ticks since the previous event | u8 input
+//   varint end tick | u32 score | u32 lines | u32 level | u32 FNV-1a of everything before it
+const char REPLAY_MAGIC[4] = {'T', 'R', 'P', 'L'};
+const uint32_t REPLAY_VERSION = 1;
+const char REPLAY_EXTENSION[] = ".trp";
+const uint32_t MAX_REPLAY_TICK_RATE = 10000; // keeps fallSpeed * tickRate far from overflowing
+
+inline std::string encodeReplay(const Replay& replay) {
+    std::string bytes(REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    putU32(bytes, REPLAY_VERSION);
+    putU32(bytes, replay.seed);
+    putU32(bytes, static_cast<uint32_t>(replay.tickRate));
+    putU32(bytes, static_cast<uint32_t>(replay.events.size()));
+    uint64_t lastTick = 0;
+    for (const ReplayEvent& event : replay.events) {
+        putVarint(bytes, event.tick - lastTick);
+        bytes.push_back(static_cast<char>(event.input));
+        lastTick = event.tick;
+    }
+    putVarint(bytes, replay.endTick);
+    putU32(bytes, static_cast<uint32_t>(replay.score));
+    putU32(bytes, static_cast<uint32_t>(replay.linesCleared));
+    putU32(bytes, static_cast<uint32_t>(replay.level));
+    putU32(bytes, fnv1a(bytes.data(), bytes.size()));
+    return bytes;
+}
+
+// Returns false for truncated, corrupt or unknown data
+inline bool decodeReplay(const std::string& bytes, Replay& out) {
+    if (bytes.size() < sizeof(REPLAY_MAGIC) + 4 || std::memcmp(bytes.data(), REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0) {
+        return false;
+    }
+    size_t checked = bytes.size() - 4;
+    size_t end = checked;
+    uint32_t checksum;
+    if (!getU32(bytes, end, checksum) || checksum != fnv1a(bytes.data(), checked)) return false;
+
+    const std::string body = bytes.substr(0, checked);
+    size_t pos = sizeof(REPLAY_MAGIC);
+    uint32_t version, seed, tickRate, count, score, lines, level;
+    if (!getU32(body, pos, version) || version != REPLAY_VERSION) return false;
+    if (!getU32(body, pos, seed) || !getU32(body, pos, tickRate) || !getU32(body, pos, count)) return false;
+    if (tickRate == 0 || tickRate > MAX_REPLAY_TICK_RATE) return false;
+    if (count > body.size()) return false; // every event takes at least two bytes
+
+    Replay replay;
+    replay.seed = seed;
+    replay.tickRate = static_cast<int>(tickRate);
+    replay.events.reserve(count);
+    uint64_t tick = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint64_t delta;
+        if (!getVarint(body, pos, delta) || pos >= body.size()) return false;
+        uint8_t input = static_cast<uint8_t>(body[pos++]);
+        if (input > static_cast<uint8_t>(Input::HardDrop)) return false;
+        tick += delta;
+        replay.events.push_back({tick, static_cast<Input>(input)});
+    }
+    if (!getVarint(body, pos, replay.endTick)) return false;
+    if (!getU32(body, pos, score) || !getU32(body, pos, lines) || !getU32(body, pos, level) || pos != body.size()) return false;
+    replay.score = static_cast<int>(score);
+    replay.linesCleared = static_cast<int>(lines);
+    replay.level = static_cast<int>(level);
+    out = std::move(replay);
+    return true;
+}
+
+inline bool readReplayFile(const std::string& path, Replay& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return decodeReplay(bytes, out);
+}
+
+inline bool writeReplayFile(const std::string& path, const Replay& replay) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    std::string bytes = encodeReplay(replay);
+    return file.write(bytes.data(), bytes.size()) && file.flush();
+}
+
+// Appends inputs as they are applied; owned by whoever drives the engine
+class ReplayRecorder {
+public:
+    // Room for a long game's inputs up front, so recording never allocates mid-game
+    static const size_t RESERVED_EVENTS = 16384;
+
+    // Keeps the event buffer's capacity from the previous game
+    void start(uint32_t seed, int tickRate) {
+        replay.events.clear();
+        replay.events.reserve(RESERVED_EVENTS);
+        replay.seed = seed;
+        replay.tickRate = tickRate;
+        replay.endTick = 0;
+        replay.score = 0;
+        replay.linesCleared = 0;
+        replay.level = 1;
+        tick = 0;
+    }
+
+    void input(Input input) {
+        if (input != Input::None) {
+            replay.events.push_back({tick, input});
+        }
+    }
+
+    void endTick() { tick++; }
+
+    // The replay so far, with the engine's current totals as the claimed result
+    template<class Engine>
+    Replay finish(const Engine& engine) const {
+        Replay result = replay;
+        result.endTick = tick;
+        result.score = engine.score;
+        result.linesCleared = engine.linesCleared;
+        result.level = engine.level;
+        return result;
+    }
+
+private:
+    Replay replay;
+    uint64_t tick = 0;
+};
+
+// Re-runs a replay on its own engine. Every keyframeInterval ticks the engine is copied,
+// so seek() only has to re-simulate from the nearest keyframe.
+class ReplayPlayer {
+public:
+    explicit ReplayPlayer(const Replay& recorded, uint64_t keyframeTicks = 600)
+        : replay(recorded), engine(recorded.seed), keyframeInterval(std::max<uint64_t>(1, keyframeTicks)) {
+        engine.tickRate = replay.tickRate;
+        keyframes.push_back({0, 0, engine});
+    }
+
+    uint64_t currentTick() const { return tick; }
+    // Nothing changes after game over, so a claimed end tick past it is not played out
+    bool finished() const { return tick >= replay.endTick || engine.gameOver; }
+    const TetrisEngine& state() const { return engine; }
+
+    // Same order as Simulation::step: this tick's inputs, then gravity
+    void step() {
+        while (nextEvent < replay.events.size() && replay.events[nextEvent].tick == tick) {
+            engine.apply(replay.events[nextEvent++].input);
+        }
+        engine.tick();
+        tick++;
+        if (tick % keyframeInterval == 0 && tick > keyframes.back().tick) {
+            keyframes.push_back({tick, nextEvent, engine});
+        }
+    }
+
+    // As fast as the CPU allows
+    void runToEnd() {
+        while (!finished()) {
+            step();
+        }
+    }
+
+    // Paced to the recorded tick rate, like the game itself
+    void runRealTime() {
+        auto tickDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / replay.tickRate));
+        auto nextTick = std::chrono::steady_clock::now();
+        while (!finished()) {
+            step();
+            nextTick += tickDuration;
+            std::this_thread::sleep_until(nextTick);
+        }
+    }
+
+    // Jumps to the state at the start of targetTick
+    void seek(uint64_t targetTick) {
+        targetTick = std::min(targetTick, replay.endTick);
+        const Keyframe* best = &keyframes.front();
+        for (const Keyframe& keyframe : keyframes) {
+            if (keyframe.tick <= targetTick) best = &keyframe;
+        }
+        if (best->tick > tick || targetTick < tick) {
+            tick = best->tick;
+            nextEvent = best->nextEvent;
+            engine = best->engine;
+        }
+        while (tick < targetTick && !finished()) {
+            step();
+        }
+    }
+
+    // True when the final engine state agrees with what the recorder claimed, including the game
+    // not ending before the claimed end tick
+    bool matchesClaim() const {
+        return tick == replay.endTick && engine.score == replay.score && engine.linesCleared == replay.linesCleared &&
+               engine.level == replay.level;
+    }
+
+private:
+    struct Keyframe {
+        uint64_t tick;
+        size_t nextEvent;
+        TetrisEngine engine;
+    };
+
+    Replay replay;
+    TetrisEngine engine;
+    uint64_t keyframeInterval;
+    uint64_t tick = 0;
+    size_t nextEvent = 0;
+    std::vector<Keyframe> keyframes;
+};
+
+// tetris --headless --replay FILE [--realtime] [--seek TICK] [--repeat N] [--keyframes K]
+// Plays a replay back and checks the recorded result; --repeat benchmarks the engine on the trace.
+inline int runReplay(int argc, char** argv) {
+    std::string path;
+    bool realTime = false;
+    long long seekTick = -1;
+    long long repeat = 1;
+    uint64_t keyframeTicks = 600;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--replay" && hasValue) path = argv[++i];
+        else if (arg == "--realtime") realTime = true;
+        else if (arg == "--seek" && hasValue) seekTick = std::atoll(argv[++i]);
+        else if (arg == "--repeat" && hasValue) repeat = std::max(1LL, std::atoll(argv[++i]));
+        else if (arg == "--keyframes" && hasValue) keyframeTicks = std::max(1LL, std::atoll(argv[++i]));
+    }
+
+    Replay replay;
+    if (!readReplayFile(path, replay)) {
+        std::cerr << "Could not read replay " << path << std::endl;
+        return 1;
+    }
+
+    ReplayPlayer player(replay, keyframeTicks);
+    if (seekTick >= 0) {
+        // Play through once so the keyframes exist, then jump back
+        player.runToEnd();
+        player.seek(static_cast<uint64_t>(seekTick));
+        const TetrisEngine& state = player.state();
+        std::cout << "tick " << player.currentTick() << ": score " << state.score << ", lines " << state.linesCleared
+                  << ", level " << state.level << ", pieces " << state.blocksPlaced << std::endl;
+        return 0;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (realTime) {
+        player.runRealTime();
+    } else {
+        player.runToEnd();
+        for (long long i = 1; i < repeat; ++i) {
+            ReplayPlayer again(replay, keyframeTicks);
+            again.runToEnd();
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const TetrisEngine& state = player.state();
+    double ticks = static_cast<double>(player.currentTick()) * (realTime ? 1 : repeat);
+    std::cout << "ticks: " << player.currentTick() << " (claimed " << replay.endTick << ")\n"
+              << "inputs: " << replay.events.size() << "\n"
+              << "score: " << state.score << " (claimed " << replay.score << ")\n"
+              << "lines: " << state.linesCleared << " (claimed " << replay.linesCleared << ")\n"
+              << "level: " << state.level << " (claimed " << replay.level << ")\n"
+              << "seconds: " << seconds << "\n"
+              << "ticks/sec: " << (seconds > 0 ? ticks / seconds : 0) << std::endl;
+    if (!player.matchesClaim()) {
+        std::cerr << "Replay result does not match the recorded result" << std::endl;
+        return 1;
+    }
+    return 0;
+}
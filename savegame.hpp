@@ -0,0 +1,317 @@
+// Versioned, checksummed save file with a background writer
+// Saves are coalesced and written on their own thread through a temp file that is synced to
+// disk before it is renamed over the save, so a crash or power loss mid-write leaves the
+// previous save intact, and no frame waits on the disk.
+#pragma once
+
+#include "binio.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+struct SaveData {
+    int coins = 0;
+    bool blueWallpaperBought = false;
+    bool greenWallpaperBought = false;
+    bool redWallpaperBought = false;
+    bool spaceBackgroundEnabled = true;
+    std::string activeWallpaper = "space"; // "space", "blue", "green", "red"
+};
+
+// Layout, all integers little-endian:
+//   "TSAV" | u32 version | u32 payload size | payload | u32 FNV-1a of the payload
+// Version 2 payload: i32 coins | u8 blue | u8 green | u8 red | u8 space | u32 length | wallpaper bytes
+const char SAVE_MAGIC[4] = {'T', 'S', 'A', 'V'};
+const uint32_t SAVE_VERSION = 2; // version 1 is the raw struct dump saveCoins used to write
+const uint32_t MAX_WALLPAPER_NAME = 64;
+
+inline std::string encodeSave(const SaveData& data) {
+    std::string payload;
+    putU32(payload, static_cast<uint32_t>(data.coins));
+    payload.push_back(data.blueWallpaperBought);
+    payload.push_back(data.greenWallpaperBought);
+    payload.push_back(data.redWallpaperBought);
+    payload.push_back(data.spaceBackgroundEnabled);
+    putU32(payload, static_cast<uint32_t>(data.activeWallpaper.size()));
+    payload += data.activeWallpaper;
+
+    std::string bytes(SAVE_MAGIC, sizeof(SAVE_MAGIC));
+    putU32(bytes, SAVE_VERSION);
+    putU32(bytes, static_cast<uint32_t>(payload.size()));
+    bytes += payload;
+    putU32(bytes, fnv1a(payload.data(), payload.size()));
+    return bytes;
+}
+
+// The old format: native int, four bools, native size_t length, then the string
+inline bool decodeLegacySave(const std::string& bytes, SaveData& out) {
+    const size_t header = sizeof(int) + 4 * sizeof(bool) + sizeof(size_t);
+    if (bytes.size() < header) return false;
+    SaveData data;
+    size_t pos = 0;
+    std::memcpy(&data.coins, bytes.data() + pos, sizeof(int));
+    pos += sizeof(int);
+    bool* flags[4] = {&data.blueWallpaperBought, &data.greenWallpaperBought, &data.redWallpaperBought, &data.spaceBackgroundEnabled};
+    for (bool* flag : flags) {
+        *flag = bytes[pos++] != 0;
+    }
+    size_t length;
+    std::memcpy(&length, bytes.data() + pos, sizeof(size_t));
+    pos += sizeof(size_t);
+    if (length > MAX_WALLPAPER_NAME || pos + length != bytes.size()) return false;
+    data.activeWallpaper.assign(bytes, pos, length);
+    out = data;
+    return true;
+}
+
+// Returns false for corrupt or unknown data; sets migrated when the legacy layout was read
+inline bool decodeSave(const std::string& bytes, SaveData& out, bool& migrated) {
+    migrated = false;
+    if (bytes.size() < sizeof(SAVE_MAGIC) || std::memcmp(bytes.data(), SAVE_MAGIC, sizeof(SAVE_MAGIC)) != 0) {
+        migrated = decodeLegacySave(bytes, out);
+        return migrated;
+    }
+
+    size_t pos = sizeof(SAVE_MAGIC);
+    uint32_t version, size, checksum;
+    if (!getU32(bytes, pos, version) || version != SAVE_VERSION) return false;
+    if (!getU32(bytes, pos, size) || pos + size + 4 != bytes.size()) return false;
+    std::string payload = bytes.substr(pos, size);
+    pos += size;
+    if (!getU32(bytes, pos, checksum) || checksum != fnv1a(payload.data(), payload.size())) return false;
+
+    SaveData data;
+    size_t p = 0;
+    uint32_t coins, length;
+    if (!getU32(payload, p, coins) || p + 4 > payload.size()) return false;
+    data.coins = static_cast<int>(coins);
+    data.blueWallpaperBought = payload[p++] != 0;
+    data.greenWallpaperBought = payload[p++] != 0;
+    data.redWallpaperBought = payload[p++] != 0;
+    data.spaceBackgroundEnabled = payload[p++] != 0;
+    if (!getU32(payload, p, length) || length > MAX_WALLPAPER_NAME || p + length != payload.size()) return false;
+    data.activeWallpaper = payload.substr(p, length);
+    out = data;
+    return true;
+}
+
+// Returns false if the file is missing or unreadable; out is left untouched then
+inline bool readSaveFile(const std::string& path, SaveData& out, bool& migrated) {
+    migrated = false;
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!decodeSave(bytes, out, migrated)) {
+        std::cerr << "Ignoring corrupt save file " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Writes bytes to a new file at path and waits until they are on the disk, not just in the OS cache
+inline bool writeFileDurably(const std::string& path, const std::string& bytes) {
+#ifdef _WIN32
+    int fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = true;
+    for (size_t written = 0; ok && written < bytes.size();) {
+#ifdef _WIN32
+        int n = _write(fd, bytes.data() + written, static_cast<unsigned>(bytes.size() - written));
+#else
+        ssize_t n = write(fd, bytes.data() + written, bytes.size() - written);
+#endif
+        ok = n > 0;
+        if (ok) written += static_cast<size_t>(n);
+    }
+#ifdef _WIN32
+    ok = ok && _commit(fd) == 0;
+    return _close(fd) == 0 && ok;
+#else
+    ok = ok && fsync(fd) == 0;
+    return close(fd) == 0 && ok;
+#endif
+}
+
+// Makes a rename inside the directory durable. Windows has no directory handles to sync.
+inline void syncDirectory(const std::filesystem::path& directory) {
+#ifndef _WIN32
+    int fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#endif
+}
+
+// Writes and syncs path.tmp, then renames it over path, so readers only ever see a complete file
+inline bool replaceFileDurably(const std::string& path, const std::string& bytes) {
+    const std::string tempPath = path + ".tmp";
+    if (!writeFileDurably(tempPath, bytes)) {
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        return false;
+    }
+    syncDirectory(std::filesystem::path(path).parent_path());
+    return true;
+}
+
+inline bool writeSaveFile(const std::string& path, const SaveData& data) {
+    return replaceFileDurably(path, encodeSave(data));
+}
+
+// Reads the save and, if it was in the legacy layout, rewrites it in the current format right away
+inline bool loadSaveFile(const std::string& path, SaveData& out) {
+    bool migrated = false;
+    if (!readSaveFile(path, out, migrated)) {
+        return false;
+    }
+    if (migrated && !writeSaveFile(path, out)) {
+        std::cerr << "Failed to upgrade save file " << path << std::endl;
+    }
+    return true;
+}
+
+// Background writer: save() only copies the data and wakes the thread.
+// Saves requested while a write is in flight collapse into one write of the newest data.
+class SaveWriter {
+public:
+    explicit SaveWriter(std::string savePath) : path(std::move(savePath)), worker([this]() { writeLoop(); }) {}
+
+    // Writes whatever is still pending before returning
+    ~SaveWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    void save(const SaveData& data) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = data;
+            hasPending = true;
+            requests++;
+        }
+        wake.notify_one();
+    }
+
+    // Blocks until every save requested so far is on disk
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this]() { return !hasPending && !writing; });
+    }
+
+    long long requestCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return requests;
+    }
+
+    long long writeCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return writes;
+    }
+
+private:
+    std::string path;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    SaveData pending;
+    bool hasPending = false;
+    bool writing = false;
+    bool stopping = false;
+    long long requests = 0;
+    long long writes = 0;
+    std::thread worker; // last, so everything above exists before the thread starts
+
+    void writeLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this]() { return hasPending || stopping; });
+            if (!hasPending) {
+                return; // stopping with nothing left to write
+            }
+            SaveData data = pending;
+            hasPending = false;
+            writing = true;
+            lock.unlock();
+            bool ok = writeSaveFile(path, data);
+            lock.lock();
+            writing = false;
+            writes++;
+            if (!ok) {
+                std::cerr << "Failed to save game data to file." << std::endl;
+            }
+            idle.notify_all();
+        }
+    }
+};
+
+// Writes a save in the legacy layout to a temp file, loads it, and checks the file on disk was
+// rewritten in the versioned format with the same contents. Exits with code 1 on any mismatch.
+inline int runSaveSelfTest() {
+    int failures = 0;
+    auto check = [&](const char* name, bool ok) {
+        failures += !ok;
+        std::cout << (ok ? "ok   " : "FAIL ") << name << std::endl;
+    };
+
+    SaveData legacy;
+    legacy.coins = 1234;
+    legacy.greenWallpaperBought = true;
+    legacy.spaceBackgroundEnabled = false;
+    legacy.activeWallpaper = "green";
+    std::string bytes(reinterpret_cast<const char*>(&legacy.coins), sizeof(int));
+    for (bool flag : {legacy.blueWallpaperBought, legacy.greenWallpaperBought, legacy.redWallpaperBought, legacy.spaceBackgroundEnabled}) {
+        bytes.push_back(flag);
+    }
+    size_t length = legacy.activeWallpaper.size();
+    bytes.append(reinterpret_cast<const char*>(&length), sizeof(size_t));
+    bytes += legacy.activeWallpaper;
+
+    const std::string path = (std::filesystem::temp_directory_path() / "tetris-save-self-test.dat").string();
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+    SaveData loaded;
+    check("legacy save loads", loadSaveFile(path, loaded));
+    check("legacy save contents", loaded.coins == legacy.coins && loaded.greenWallpaperBought && !loaded.blueWallpaperBought &&
+                                  !loaded.spaceBackgroundEnabled && loaded.activeWallpaper == legacy.activeWallpaper);
+
+    std::ifstream file(path, std::ios::binary);
+    std::string onDisk((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    SaveData reread;
+    bool migrated = true;
+    check("file rewritten in the versioned format", onDisk == encodeSave(legacy) && decodeSave(onDisk, reread, migrated) && !migrated);
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    return failures ? 1 : 0;
+}
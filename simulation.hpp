@@ -0,0 +1,201 @@
+// Fixed-timestep driver for a BasicEngine of any board size (Simulation drives the classic TetrisEngine)
+// Inputs are queued and applied on tick boundaries, and every tick publishes a snapshot
+// for the renderer. Ticks run inline from the render loop or on their own thread.
+#pragma once
+
+#include "engine.hpp"
+#include "replay.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Everything the renderer needs from one simulation tick
+template<class Engine>
+struct BasicSnapshot {
+    typename Engine::BoardType board;
+    Piece currentPiece{};
+    Piece previousPiece{};      // currentPiece one tick earlier
+    bool pieceContinues = false; // previousPiece is the same piece, so it can be interpolated
+    Piece nextPiece{};
+    int ghostY = 0;             // landing row of currentPiece
+    int score = 0;
+    int level = 1;
+    int linesCleared = 0;
+    int blocksPlaced = 0;
+    uint32_t boardRevision = 0;
+    bool gameOver = false;
+    uint64_t tick = 0;
+};
+
+template<class Engine>
+class BasicSimulation {
+public:
+    // Never run more than this many ticks to catch up after a stall
+    static const int MAX_CATCH_UP_TICKS = 5;
+
+    BasicSimulation(Engine& gameEngine, int ticksPerSecond)
+        : engine(gameEngine), tickRate(std::max(1, ticksPerSecond)) {
+        engine.tickRate = tickRate;
+        publish(engine.currentPiece, false);
+    }
+
+    ~BasicSimulation() {
+        stopThread();
+    }
+
+    int getTickRate() const { return tickRate; }
+    double tickSeconds() const { return 1.0 / tickRate; }
+
+    void queueInput(Input input) {
+        std::lock_guard<std::mutex> lock(engineMutex);
+        pendingInputs.push_back(input);
+    }
+
+    // Reseeds and resets the engine and publishes the fresh game right away.
+    // The seed starts a new recording, so every game can be replayed.
+    void reset(uint32_t seed) {
+        std::lock_guard<std::mutex> lock(engineMutex);
+        engine.reset(seed);
+        recorder.start(seed, tickRate);
+        pendingInputs.clear();
+        publish(engine.currentPiece, false);
+    }
+
+    // The current game's inputs so far, with its current totals as the result
+    Replay recording() {
+        std::lock_guard<std::mutex> lock(engineMutex);
+        return recorder.finish(engine);
+    }
+
+    // While paused, ticks still publish but the game does not move
+    void setPaused(bool value) { paused = value; }
+
+    // Inline mode: runs as many whole ticks as fit into the elapsed time
+    void advance(double seconds) {
+        accumulator = std::min(accumulator + seconds, MAX_CATCH_UP_TICKS * tickSeconds());
+        while (accumulator >= tickSeconds()) {
+            step();
+            accumulator -= tickSeconds();
+        }
+    }
+
+    // How far the present is between the latest snapshot and the next tick, in [0, 1]
+    float interpolation() const {
+        double elapsed;
+        if (threaded()) {
+            auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::duration(now - publishedAt.load())).count();
+        } else {
+            elapsed = accumulator;
+        }
+        return static_cast<float>(std::clamp(elapsed / tickSeconds(), 0.0, 1.0));
+    }
+
+    void startThread() {
+        if (worker.joinable()) return;
+        running = true;
+        worker = std::thread([this]() { threadLoop(); });
+    }
+
+    void stopThread() {
+        running = false;
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    bool threaded() const { return worker.joinable(); }
+
+    // Copies the newest snapshot into out; returns false if there is nothing new since the last call
+    bool latest(BasicSnapshot<Engine>& out) {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        if (sequence == lastRead) {
+            return false;
+        }
+        out = snapshots[front];
+        lastRead = sequence;
+        return true;
+    }
+
+private:
+    Engine& engine;
+    int tickRate;
+    double accumulator = 0.0;
+    std::atomic<bool> paused{false};
+    std::atomic<bool> running{false};
+    std::thread worker;
+
+    // Guards the engine and the input queue
+    std::mutex engineMutex;
+    std::vector<Input> pendingInputs;
+    uint64_t ticks = 0;
+    ReplayRecorder recorder;
+
+    // Double-buffered snapshots: the simulation fills the back one, then swaps
+    std::mutex snapshotMutex;
+    BasicSnapshot<Engine> snapshots[2];
+    int front = 0;
+    uint64_t sequence = 0;
+    uint64_t lastRead = 0;
+    std::atomic<std::chrono::steady_clock::rep> publishedAt{0};
+
+    void step() {
+        std::lock_guard<std::mutex> lock(engineMutex);
+        Piece before = engine.currentPiece;
+        int placedBefore = engine.blocksPlaced;
+        if (!paused && !engine.gameOver) {
+            for (Input input : pendingInputs) {
+                engine.apply(input);
+                recorder.input(input);
+            }
+            engine.tick();
+            recorder.endTick();
+            ticks++;
+        }
+        pendingInputs.clear();
+        publish(before, engine.blocksPlaced == placedBefore);
+    }
+
+    // Called with engineMutex held
+    void publish(const Piece& previous, bool continues) {
+        BasicSnapshot<Engine>& back = snapshots[1 - front];
+        back.board = engine.board;
+        back.currentPiece = engine.currentPiece;
+        back.previousPiece = previous;
+        back.pieceContinues = continues;
+        back.nextPiece = engine.nextPiece;
+        back.ghostY = engine.ghostY;
+        back.score = engine.score;
+        back.level = engine.level;
+        back.linesCleared = engine.linesCleared;
+        back.blocksPlaced = engine.blocksPlaced;
+        back.boardRevision = engine.boardRevision;
+        back.gameOver = engine.gameOver;
+        back.tick = ticks;
+
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        front = 1 - front;
+        sequence++;
+        publishedAt = std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    void threadLoop() {
+        auto tickDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(tickSeconds()));
+        auto nextTick = std::chrono::steady_clock::now();
+        while (running) {
+            step();
+            nextTick += tickDuration;
+            auto now = std::chrono::steady_clock::now();
+            if (now - nextTick > tickDuration * MAX_CATCH_UP_TICKS) {
+                nextTick = now; // fell too far behind, drop the backlog instead of spiralling
+            }
+            std::this_thread::sleep_until(nextTick);
+        }
+    }
+};
+
+using GameSnapshot = BasicSnapshot<TetrisEngine>;
+using Simulation = BasicSimulation<TetrisEngine>;
@@ -0,0 +1,661 @@
+// Puzzle solver: given a board and a known piece queue, searches placement sequences for a
+// perfect clear or for the most cleared lines. Depth-first over reachable placements, with a
+// bounded transposition table shared by all threads and keyed by Zobrist hashes of the board.
+// Usage: tetris --headless --solve [--board FILE] (--queue IJLOSTZ | --seed S --pieces N)
+//                                  [--goal lines|pc] [--pc-height H] [--tt-mb M] [--threads T]
+//        tetris --headless --solve --self-test
+#pragma once
+
+#include "ai.hpp"
+#include "features.hpp"
+#include "movegen.hpp"
+#include "threadpool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+const int SOLVER_MAX_QUEUE = 64;
+
+// One random key per cell and per queue position; a board hashes to the XOR of its filled cells.
+// The cell keys are pre-combined per row value, so hashing a board is one lookup per row.
+class ZobristKeys {
+public:
+    explicit ZobristKeys(uint64_t seed = 0x5EED5EEDull) {
+        uint64_t state = seed;
+        uint64_t cells[BOARD_HEIGHT][BOARD_WIDTH];
+        for (auto& row : cells) {
+            for (uint64_t& key : row) key = splitMix(state);
+        }
+        for (uint64_t& key : pieces) key = splitMix(state);
+        rowKeys.resize(static_cast<size_t>(BOARD_HEIGHT) << BOARD_WIDTH);
+        for (int y = 0; y < BOARD_HEIGHT; ++y) {
+            uint64_t* keys = &rowKeys[static_cast<size_t>(y) << BOARD_WIDTH];
+            for (uint32_t mask = 1; mask < (1u << BOARD_WIDTH); ++mask) {
+                int x = 0;
+                while (!((mask >> x) & 1u)) ++x;
+                keys[mask] = keys[mask & (mask - 1)] ^ cells[y][x];
+            }
+        }
+    }
+
+    uint64_t board(const BoardRows& rows) const {
+        uint64_t hash = 0;
+        for (int y = 0; y < BOARD_HEIGHT; ++y) {
+            hash ^= rowKeys[(static_cast<size_t>(y) << BOARD_WIDTH) | rows[y]];
+        }
+        return hash;
+    }
+
+    uint64_t piece(int index) const { return pieces[index]; }
+
+private:
+    std::vector<uint64_t> rowKeys;
+    uint64_t pieces[SOLVER_MAX_QUEUE];
+
+    static uint64_t splitMix(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+};
+
+// Fixed-size, always-replace table shared between threads without locks. Each entry stores
+// key ^ data next to data, so a torn write from two threads fails the check instead of
+// returning another position's result.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes) {
+        size_t count = 1;
+        while (count * 2 * sizeof(Entry) <= std::max<size_t>(1, megabytes) << 20) count *= 2;
+        entries.reset(new Entry[count]);
+        mask = count - 1;
+    }
+
+    size_t size() const { return mask + 1; }
+
+    bool probe(uint64_t key, uint32_t& data) const {
+        const Entry& entry = entries[key & mask];
+        uint64_t stored = entry.data.load(std::memory_order_relaxed);
+        if ((entry.check.load(std::memory_order_relaxed) ^ stored) != key || !(stored & VALID)) {
+            return false;
+        }
+        data = static_cast<uint32_t>(stored);
+        return true;
+    }
+
+    void store(uint64_t key, uint32_t data) {
+        Entry& entry = entries[key & mask];
+        uint64_t stored = VALID | data;
+        entry.check.store(key ^ stored, std::memory_order_relaxed);
+        entry.data.store(stored, std::memory_order_relaxed);
+    }
+
+private:
+    static const uint64_t VALID = 1ull << 63;
+    struct Entry {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> data{0};
+    };
+    std::unique_ptr<Entry[]> entries;
+    size_t mask = 0;
+};
+
+struct SolverOptions {
+    bool perfectClear = false; // otherwise the most lines
+    int pcHeight = 4;          // perfect-clear search keeps the stack within this many rows
+    size_t tableMegabytes = 64;
+    int threads = 0;           // 0 for one per core
+};
+
+struct SolverStats {
+    long long nodes = 0;
+    long long probes = 0;
+    long long hits = 0;
+};
+
+struct SolveResult {
+    bool perfectClear = false;
+    int lines = 0;
+    std::vector<Placement> placements; // one per piece used, in queue order
+    SolverStats stats;
+    double seconds = 0;
+};
+
+inline Piece spawnPiece(char shape) {
+    return Piece{shape, 0, PIECE_COLORS[shapeIndex(shape)], BOARD_WIDTH / 2 - 2, 0};
+}
+
+inline int filledCells(const BoardRows& rows) {
+    int cells = 0;
+    for (RowMask row : rows) cells += static_cast<int>(popcount16(row));
+    return cells;
+}
+
+// Most lines `pieces` more pieces could clear: every cleared line is a different row whose empty
+// cells all have to be filled, so take rows cheapest first until the four cells per piece run out.
+// Clears bring new empty rows in at the top, so once every row on the board is used up the cells
+// left over can still build whole rows of BOARD_WIDTH above the current stack.
+inline int lineBound(const BoardRows& rows, int pieces) {
+    int rowsWithEmpty[BOARD_WIDTH + 1] = {};
+    for (RowMask row : rows) rowsWithEmpty[BOARD_WIDTH - popcount16(row)]++;
+    int cells = 4 * pieces, lines = 0;
+    for (int empty = 1; empty <= BOARD_WIDTH; ++empty) {
+        int fillable = std::min(rowsWithEmpty[empty], cells / empty);
+        lines += fillable;
+        cells -= fillable * empty;
+        if (fillable < rowsWithEmpty[empty]) return lines;
+    }
+    return lines + cells / BOARD_WIDTH;
+}
+
+class PuzzleSolver {
+public:
+    PuzzleSolver(std::vector<char> pieceQueue, const SolverOptions& solverOptions)
+        : queue(std::move(pieceQueue)), options(solverOptions), table(solverOptions.tableMegabytes),
+          pool(solverOptions.threads) {
+        queue.resize(std::min<size_t>(queue.size(), SOLVER_MAX_QUEUE));
+    }
+
+    int threads() const { return pool.size(); }
+    size_t tableEntries() const { return table.size(); }
+
+    SolveResult solve(const BoardRows& start) {
+        auto begin = std::chrono::steady_clock::now();
+        SolveResult result;
+        origin = start;
+        bestLines = 0;
+        stop = false;
+        // The first two pieces are expanded up front; each of their combinations is a parallel task
+        std::vector<Task> tasks;
+        Worker root(queue.size());
+        split(root, start, 0, 0, {}, tasks, result);
+        stats = root.stats;
+        if (!result.perfectClear) {
+            if (options.perfectClear) {
+                solvePerfectClear(tasks, result);
+            } else {
+                solveLines(tasks, result);
+            }
+        }
+        result.stats = stats;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return result;
+    }
+
+private:
+    static const int SPLIT_DEPTH = 2;
+    static const uint32_t EXACT = 1u << 8;
+
+    struct Child {
+        Placement placement;
+        BoardRows rows;
+        int cleared;
+        int bound; // cleared plus the most lines the pieces after it could clear
+    };
+
+    // Per-thread scratch: a move generator and one child list per queue position
+    struct Worker {
+        explicit Worker(size_t depth) : levels(depth) {}
+        MoveGenerator moves;
+        std::vector<std::vector<Child>> levels;
+        SolverStats stats;
+    };
+
+    struct Task {
+        BoardRows rows;
+        int gained;
+        std::vector<Placement> prefix;
+    };
+
+    std::vector<char> queue;
+    SolverOptions options;
+    ZobristKeys keys;
+    TranspositionTable table;
+    ThreadPool pool;
+    BoardRows origin{};
+    std::atomic<int> bestLines{0};
+    bool sharedFloor = false;  // prune against bestLines, only while the tasks run
+    std::atomic<bool> stop{false};
+    std::mutex statsMutex;
+    SolverStats stats;
+
+    void addStats(const SolverStats& s) {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.nodes += s.nodes;
+        stats.probes += s.probes;
+        stats.hits += s.hits;
+    }
+
+    bool probe(Worker& w, uint64_t key, uint32_t& data) {
+        w.stats.probes++;
+        bool hit = table.probe(key, data);
+        w.stats.hits += hit;
+        return hit;
+    }
+
+    // Every placement of queue[index] that spawns, with the board it leaves; the most promising
+    // first, so good lines are found early and raise the floor for the rest
+    std::vector<Child>& children(Worker& w, const BoardRows& rows, int index) {
+        std::vector<Child>& list = w.levels[index];
+        list.clear();
+        const char shape = queue[index];
+        Piece piece = spawnPiece(shape);
+        const ShapeRotation& r = shapeRotation(shape, 0);
+        if (!rowsFit(rows, r.rows, r.height, piece.x, piece.y)) {
+            return list; // topped out
+        }
+        w.moves.generate(rows, piece, [&](const Placement& p) {
+            Child child{p, rows, 0, 0};
+            child.cleared = lockPlacement(child.rows, shape, p);
+            child.bound = child.cleared + lineBound(child.rows, static_cast<int>(queue.size()) - index - 1);
+            list.push_back(child);
+        });
+        std::stable_sort(list.begin(), list.end(), [](const Child& a, const Child& b) {
+            return a.bound != b.bound ? a.bound > b.bound : a.cleared > b.cleared;
+        });
+        return list;
+    }
+
+    bool withinHeight(const BoardRows& rows) const {
+        for (int y = 0; y < BOARD_HEIGHT - options.pcHeight; ++y) {
+            if (rows[y]) return false;
+        }
+        return true;
+    }
+
+    // A perfect clear that takes `lines` more lines keeps every piece within the bottom `lines`
+    // rows, each piece filling four cells of one empty region there, so every region has to hold
+    // a multiple of four cells. Line clears only merge regions, so this holds all the way down.
+    static bool regionsFillable(const BoardRows& rows, int lines) {
+        const int top = BOARD_HEIGHT - lines;
+        BoardRows open{};
+        for (int y = top; y < BOARD_HEIGHT; ++y) open[y] = static_cast<RowMask>(~rows[y] & FULL_ROW);
+        for (int y = top; y < BOARD_HEIGHT; ++y) {
+            while (open[y]) {
+                BoardRows region{};
+                region[y] = static_cast<RowMask>(open[y] & (~open[y] + 1));
+                for (bool grew = true; grew;) {
+                    grew = false;
+                    for (int ry = top; ry < BOARD_HEIGHT; ++ry) {
+                        uint32_t r = region[ry];
+                        r |= r << 1 | r >> 1;
+                        if (ry > top) r |= region[ry - 1];
+                        if (ry + 1 < BOARD_HEIGHT) r |= region[ry + 1];
+                        r &= open[ry];
+                        if (r != region[ry]) {
+                            region[ry] = static_cast<RowMask>(r);
+                            grew = true;
+                        }
+                    }
+                }
+                int size = 0;
+                for (int ry = top; ry < BOARD_HEIGHT; ++ry) {
+                    size += static_cast<int>(popcount16(region[ry]));
+                    open[ry] &= static_cast<RowMask>(~region[ry]);
+                }
+                if (size % 4 != 0) return false;
+            }
+        }
+        return true;
+    }
+
+    static bool empty(const BoardRows& rows) {
+        for (RowMask row : rows) {
+            if (row) return false;
+        }
+        return true;
+    }
+
+    // Expands the first SPLIT_DEPTH pieces into tasks; a perfect clear inside them ends the search
+    void split(Worker& w, const BoardRows& rows, int index, int gained, std::vector<Placement> prefix,
+               std::vector<Task>& tasks, SolveResult& result) {
+        if (result.perfectClear) return;
+        if (index == SPLIT_DEPTH || index == static_cast<int>(queue.size())) {
+            tasks.push_back({rows, gained, prefix});
+            return;
+        }
+        w.stats.nodes++;
+        std::vector<Child> list = children(w, rows, index);
+        if (list.empty()) {
+            tasks.push_back({rows, gained, prefix}); // game over here, the lines so far still count
+            return;
+        }
+        for (const Child& child : list) {
+            if (options.perfectClear && !withinHeight(child.rows)) continue;
+            prefix.push_back(child.placement);
+            if (options.perfectClear && empty(child.rows)) {
+                result.perfectClear = true;
+                result.lines = gained + child.cleared;
+                result.placements = prefix;
+                return;
+            }
+            split(w, child.rows, index + 1, gained + child.cleared, prefix, tasks, result);
+            prefix.pop_back();
+        }
+    }
+
+    // An upper bound on the lines the rest of the queue can clear, and whether it is also reached
+    struct LineBound {
+        int value;
+        bool exact;
+    };
+
+    // Most lines the rest of the queue can clear from this board. When the result is not exact it
+    // is an upper bound no higher than floor (or than the shared best, less gained), which is all
+    // a caller at that floor needs.
+    LineBound maxLines(Worker& w, const BoardRows& rows, int index, int gained, int floor) {
+        w.stats.nodes++;
+        const int remaining = static_cast<int>(queue.size()) - index;
+        if (remaining == 0) return {0, true};
+        if (sharedFloor) {
+            floor = std::max(floor, bestLines.load(std::memory_order_relaxed) - gained);
+        }
+        const int bound = lineBound(rows, remaining);
+        if (bound <= floor) return {bound, false};
+
+        const uint64_t key = keys.board(rows) ^ keys.piece(index);
+        uint32_t data;
+        if (probe(w, key, data)) {
+            int value = static_cast<int>(data & 0xFF);
+            if ((data & EXACT) || value <= floor) return {value, (data & EXACT) != 0};
+        }
+
+        // best bounds every child, reached is the most some child is known to clear
+        int best = 0, reached = 0;
+        for (const Child& child : children(w, rows, index)) {
+            int alpha = std::max(floor, best);
+            if (child.bound <= alpha) {
+                best = std::max(best, child.bound); // children come sorted, so none of the rest can beat alpha
+                break;
+            }
+            LineBound result = maxLines(w, child.rows, index + 1, gained + child.cleared, alpha - child.cleared);
+            best = std::max(best, child.cleared + result.value);
+            if (result.exact) reached = std::max(reached, child.cleared + result.value);
+        }
+        const bool exact = reached >= best;
+        table.store(key, static_cast<uint32_t>(best) | (exact ? EXACT : 0));
+        if (sharedFloor) {
+            raiseBest(gained + reached);
+        }
+        return {best, exact};
+    }
+
+    void raiseBest(int lines) {
+        int current = bestLines.load();
+        while (lines > current && !bestLines.compare_exchange_weak(current, lines)) {}
+    }
+
+    // Tasks raise the shared best as they find lines, and every prune is against a bound no
+    // higher than it, so once they finish the shared best is the answer
+    void solveLines(const std::vector<Task>& tasks, SolveResult& result) {
+        sharedFloor = true;
+        pool.parallelFor(tasks.size(), [&](size_t i) {
+            Worker w(queue.size());
+            const Task& task = tasks[i];
+            raiseBest(task.gained);
+            maxLines(w, task.rows, static_cast<int>(task.prefix.size()), task.gained, -1);
+            addStats(w.stats);
+        });
+        result.lines = bestLines;
+
+        // Walk down from the start, at each piece re-searching the children with floor target - 1
+        // until one reaches the target; the table already holds most of these positions. Without
+        // the shared floor, a result at or above the target is exact.
+        sharedFloor = false;
+        Worker w(queue.size());
+        BoardRows rows = origin;
+        int target = result.lines;
+        for (int index = 0; index < static_cast<int>(queue.size()); ++index) {
+            std::vector<Child> list = children(w, rows, index);
+            bool advanced = false;
+            for (const Child& child : list) {
+                if (child.cleared + maxLines(w, child.rows, index + 1, 0, target - child.cleared - 1).value >= target) {
+                    result.placements.push_back(child.placement);
+                    rows = child.rows;
+                    target -= child.cleared;
+                    advanced = true;
+                    break;
+                }
+            }
+            if (!advanced) break; // topped out; the remaining pieces don't matter
+        }
+        addStats(w.stats);
+    }
+
+    // True when the rest of the queue can empty the board; appends the placements in reverse
+    bool findPerfectClear(Worker& w, const BoardRows& rows, int index, std::vector<Placement>& reversed) {
+        w.stats.nodes++;
+        const int remaining = static_cast<int>(queue.size()) - index;
+        if (remaining == 0 || stop.load(std::memory_order_relaxed)) return false;
+        // Some number of lines, no fewer than the stack is tall, has to be fillable by the pieces left
+        const int cells = filledCells(rows);
+        int stack = BOARD_HEIGHT;
+        while (stack > 0 && rows[BOARD_HEIGHT - stack] == 0) --stack;
+        bool reachable = false;
+        for (int lines = stack; lines <= options.pcHeight && !reachable; ++lines) {
+            int missing = lines * BOARD_WIDTH - cells;
+            reachable = missing > 0 && missing % 4 == 0 && missing / 4 <= remaining && regionsFillable(rows, lines);
+        }
+        if (!reachable) return false;
+
+        const uint64_t key = keys.board(rows) ^ keys.piece(index);
+        uint32_t data;
+        if (probe(w, key, data)) return false; // only dead ends are stored
+
+        for (const Child& child : children(w, rows, index)) {
+            if (!withinHeight(child.rows)) continue;
+            if (empty(child.rows) || findPerfectClear(w, child.rows, index + 1, reversed)) {
+                reversed.push_back(child.placement);
+                return true;
+            }
+        }
+        if (!stop.load(std::memory_order_relaxed)) {
+            table.store(key, 0);
+        }
+        return false;
+    }
+
+    void solvePerfectClear(const std::vector<Task>& tasks, SolveResult& result) {
+        std::mutex found;
+        pool.parallelFor(tasks.size(), [&](size_t i) {
+            if (stop) return;
+            Worker w(queue.size());
+            const Task& task = tasks[i];
+            std::vector<Placement> reversed;
+            if (findPerfectClear(w, task.rows, static_cast<int>(task.prefix.size()), reversed)) {
+                std::lock_guard<std::mutex> lock(found);
+                if (!stop.exchange(true)) {
+                    result.perfectClear = true;
+                    result.placements = task.prefix;
+                    result.placements.insert(result.placements.end(), reversed.rbegin(), reversed.rend());
+                }
+            }
+            addStats(w.stats);
+        });
+        if (result.perfectClear) {
+            result.lines = countLines(result.placements);
+        }
+    }
+
+    int countLines(const std::vector<Placement>& placements) const {
+        BoardRows rows = origin;
+        int lines = 0;
+        for (size_t i = 0; i < placements.size(); ++i) {
+            lines += lockPlacement(rows, queue[i], placements[i]);
+        }
+        return lines;
+    }
+};
+
+// One string per row with '.' or ' ' for empty cells and anything else filled, aligned to the
+// bottom of the board; full rows are cleared
+inline BoardRows parseBoardLines(const std::vector<std::string>& lines) {
+    BoardRows rows{};
+    int offset = BOARD_HEIGHT - static_cast<int>(lines.size());
+    for (int i = std::max(0, -offset); i < static_cast<int>(lines.size()); ++i) {
+        RowMask row = 0;
+        for (int x = 0; x < BOARD_WIDTH && x < static_cast<int>(lines[i].size()); ++x) {
+            if (lines[i][x] != '.' && lines[i][x] != ' ') row |= static_cast<RowMask>(1u << x);
+        }
+        rows[offset + i] = row;
+    }
+    clearFullRowMasks(rows);
+    return rows;
+}
+
+// Board file: the rows parseBoardLines takes, one per line
+inline bool readBoardFile(const std::string& path, BoardRows& rows) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(file, line);) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) lines.push_back(line);
+    }
+    rows = parseBoardLines(lines);
+    return true;
+}
+
+// Most lines any placement sequence clears, with no bounds and no table. Only for short queues.
+inline int exhaustiveLines(MoveGenerator& moves, const BoardRows& rows, const std::vector<char>& queue, size_t index) {
+    if (index == queue.size()) return 0;
+    Piece piece = spawnPiece(queue[index]);
+    const ShapeRotation& r = shapeRotation(queue[index], 0);
+    if (!rowsFit(rows, r.rows, r.height, piece.x, piece.y)) return 0;
+    std::vector<Placement> placements;
+    moves.generate(rows, piece, [&](const Placement& p) { placements.push_back(p); });
+    int best = 0;
+    for (const Placement& p : placements) {
+        BoardRows next = rows;
+        int cleared = lockPlacement(next, queue[index], p);
+        best = std::max(best, cleared + exhaustiveLines(moves, next, queue, index + 1));
+    }
+    return best;
+}
+
+// Checks lineBound on hand-built boards and the solver against exhaustive search on small puzzles
+inline int runSolverSelfTest() {
+    int failures = 0;
+    auto check = [&](const char* name, int got, int expected) {
+        bool ok = got == expected;
+        failures += !ok;
+        std::cout << (ok ? "ok   " : "FAIL ") << name << ": " << got << " (expected " << expected << ")" << std::endl;
+    };
+
+    // Every row one cell short: ten pieces fill all twenty rows and have 20 cells left for two
+    // more rows built above the stack
+    std::vector<std::string> well(BOARD_HEIGHT, ".XXXXXXXXX");
+    check("bound, rows used up", lineBound(parseBoardLines(well), 10), 22);
+    check("bound, empty board", lineBound(BoardRows{}, 5), 2);
+    check("bound, one short row", lineBound(parseBoardLines({"XXXXXX.XXX"}), 1), 1);
+
+    // In the second puzzle the lower rows have covered holes, so every line after the top row's has
+    // to be built above the stack
+    struct Puzzle {
+        const char* name;
+        std::vector<std::string> board;
+        const char* queue;
+    };
+    const Puzzle puzzles[] = {
+        {"solve, empty board", {}, "IIOO"},
+        {"solve, above the stack", {"XXXX......", ".XXXXXXXXX", "XXXXXXXXX."}, "IJLO"},
+        {"solve, tuck under", {"XXX...XXXX", "XXXX.XXXXX", "XXXX..XXXX"}, "TSZO"},
+    };
+    for (const Puzzle& puzzle : puzzles) {
+        std::vector<char> queue(puzzle.queue, puzzle.queue + std::strlen(puzzle.queue));
+        BoardRows start = parseBoardLines(puzzle.board);
+        MoveGenerator moves;
+        int expected = exhaustiveLines(moves, start, queue, 0);
+        SolverOptions options;
+        options.threads = 1;
+        options.tableMegabytes = 1;
+        PuzzleSolver solver(queue, options);
+        check(puzzle.name, solver.solve(start).lines, expected);
+    }
+    return failures ? 1 : 0;
+}
+
+inline int runSolver(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--self-test") return runSolverSelfTest();
+    }
+    SolverOptions options;
+    std::string boardPath, queueText;
+    uint32_t seed = 1;
+    int pieces = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--board" && hasValue) boardPath = argv[++i];
+        else if (arg == "--queue" && hasValue) queueText = argv[++i];
+        else if (arg == "--seed" && hasValue) seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--pieces" && hasValue) pieces = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--goal" && hasValue) options.perfectClear = std::string(argv[++i]) == "pc";
+        else if (arg == "--pc-height" && hasValue) options.pcHeight = std::min(BOARD_HEIGHT, std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--tt-mb" && hasValue) options.tableMegabytes = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads" && hasValue) options.threads = std::max(0, std::atoi(argv[++i]));
+    }
+
+    BoardRows start{};
+    if (!boardPath.empty() && !readBoardFile(boardPath, start)) {
+        std::cerr << "Could not read board file " << boardPath << std::endl;
+        return 1;
+    }
+    // The queue is either given, or the pieces a game with this seed deals
+    std::vector<char> queue;
+    for (char c : queueText) {
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        if (std::find(std::begin(SHAPE_NAMES), std::end(SHAPE_NAMES), c) != std::end(SHAPE_NAMES)) queue.push_back(c);
+    }
+    if (queue.empty() && pieces > 0) {
+        TetrisEngine engine(seed);
+        queue.push_back(engine.currentPiece.shape);
+        queue.push_back(engine.nextPiece.shape);
+        while (static_cast<int>(queue.size()) < pieces) queue.push_back(engine.getNewPiece().shape);
+        queue.resize(pieces);
+    }
+    if (queue.empty()) {
+        std::cerr << "No piece queue: give --queue IJLOSTZ or --seed S --pieces N" << std::endl;
+        return 1;
+    }
+    if (queue.size() > static_cast<size_t>(SOLVER_MAX_QUEUE)) {
+        std::cerr << "Queue cut to " << SOLVER_MAX_QUEUE << " pieces" << std::endl;
+    }
+
+    PuzzleSolver solver(queue, options);
+    SolveResult result = solver.solve(start);
+
+    std::cout << "queue: " << std::string(queue.begin(), queue.end()) << "\n"
+              << "goal: " << (options.perfectClear ? "perfect clear" : "most lines") << "\n";
+    if (options.perfectClear) {
+        std::cout << "perfect clear: " << (result.perfectClear ? "yes" : "no") << "\n";
+    }
+    std::cout << "lines: " << result.lines << "\n"
+              << "placements:";
+    for (size_t i = 0; i < result.placements.size(); ++i) {
+        const Placement& p = result.placements[i];
+        std::cout << " " << queue[i] << "(r" << p.rotation << " x" << p.x << " y" << p.y << ")";
+    }
+    const SolverStats& s = result.stats;
+    std::cout << "\n"
+              << "nodes: " << s.nodes << "\n"
+              << "nodes/sec: " << (result.seconds > 0 ? s.nodes / result.seconds : 0) << "\n"
+              << "table entries: " << solver.tableEntries() << "\n"
+              << "table probes: " << s.probes << "\n"
+              << "table hit rate: " << (s.probes > 0 ? 100.0 * s.hits / s.probes : 0) << "%\n"
+              << "threads: " << solver.threads() << "\n"
+              << "seconds: " << result.seconds << std::endl;
+    return 0;
+}
@@ -0,0 +1,64 @@
+// Startup stage timings, measured from process start
+// Stages may be recorded from the asset loading thread as well as the main thread.
+#pragma once
+
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Initialized before main() runs, so it is as close to process start as we can get portably
+inline const std::chrono::steady_clock::time_point PROCESS_START = std::chrono::steady_clock::now();
+
+inline double msSinceProcessStart() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - PROCESS_START).count();
+}
+
+class StartupTimeline {
+public:
+    struct Stage {
+        std::string name;
+        double startMs;
+        double durationMs;
+        bool background; // ran on the asset loading thread
+    };
+
+    // Runs work() and records how long it took
+    template<class Work>
+    void measure(const std::string& name, Work work, bool background = false) {
+        double start = msSinceProcessStart();
+        work();
+        record(name, start, msSinceProcessStart() - start, background);
+    }
+
+    void record(const std::string& name, double startMs, double durationMs, bool background = false) {
+        std::lock_guard<std::mutex> lock(mutex);
+        stages.push_back({name, startMs, durationMs, background});
+    }
+
+    void markFirstFrame() { firstFrameMs = msSinceProcessStart(); }
+    void markReady() { readyMs = msSinceProcessStart(); }
+
+    double timeToFirstFrame() const { return firstFrameMs; }
+    double timeToReady() const { return readyMs; }
+
+    // One line per stage, then a summary line that is easy to grep and compare across releases
+    void report(std::ostream& out) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        out << std::fixed << std::setprecision(2);
+        for (const Stage& stage : stages) {
+            out << "startup stage " << stage.name << (stage.background ? " (async)" : "")
+                << ": start " << stage.startMs << " ms, took " << stage.durationMs << " ms" << std::endl;
+        }
+        out << "startup: first frame " << firstFrameMs << " ms, ready " << readyMs << " ms" << std::endl;
+        out << std::defaultfloat;
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::vector<Stage> stages;
+    double firstFrameMs = 0.0;
+    double readyMs = 0.0;
+};
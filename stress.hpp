@@ -0,0 +1,235 @@
+// Large-board stress test: collision checks, line clears and whole random games on boards far
+// bigger than 10x20. Each size is its own BasicEngine specialization, compiled in below.
+// Usage: tetris --headless --stress [--size WxH] [--iterations N] [--games N] [--max-pieces P] [--seed S]
+//        sizes: 10x20, 16x40, 32x100, 64x1000 (all of them by default)
+#pragma once
+
+#include "engine.hpp"
+#include "bench.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+struct StressOptions {
+    std::string size;            // empty for every size
+    long long iterations = 1000000; // collision checks per size
+    long long clears = 20000;    // line clears per size and method
+    long long games = 5;
+    int maxPieces = 20000;
+    uint32_t seed = 1;
+    double fill = 0.9;           // share of the rows the clearing test keeps stacked
+};
+
+inline StressOptions parseStressOptions(int argc, char** argv) {
+    StressOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--size" && hasValue) options.size = argv[++i];
+        else if (arg == "--iterations" && hasValue) options.iterations = std::max(1LL, std::atoll(argv[++i]));
+        else if (arg == "--clears" && hasValue) options.clears = std::max(1LL, std::atoll(argv[++i]));
+        else if (arg == "--games" && hasValue) options.games = std::max(0LL, std::atoll(argv[++i]));
+        else if (arg == "--max-pieces" && hasValue) options.maxPieces = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--seed" && hasValue) options.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    return options;
+}
+
+// Fills row y with random cells, leaving at least one hole so it never counts as full
+template<class BoardT>
+void fillStressRow(BoardT& board, int y, std::mt19937& rng) {
+    const int W = BoardT::WIDTH;
+    int hole = static_cast<int>(rng() % W);
+    for (int x = 0; x < W; ++x) {
+        if (x != hole && (rng() & 1)) board.set(x, y, rng() | 0xFF);
+    }
+}
+
+// The board this engine had before its rows went into a ring: a flat array of masks and colours
+// stored by row, where a clear copies every row above a cleared line down one at a time,
+// colours included. The column heights are updated the same way clearFullRows does it.
+template<int W, int H>
+struct FlatBoard {
+    static constexpr int WIDTH = W;
+    static constexpr int HEIGHT = H;
+    using Mask = typename BasicBoard<W, H>::Mask;
+
+    std::array<Mask, H> rows{};
+    std::array<uint32_t, W * H> colors{};
+    typename BasicBoard<W, H>::ColumnTops columnTops;
+
+    explicit FlatBoard(const BasicBoard<W, H>& board) : columnTops(board.columnTops) {
+        for (int y = 0; y < H; ++y) {
+            rows[y] = board.row(y);
+            for (int x = 0; x < W; ++x) colors[y * W + x] = board.cell(x, y);
+        }
+    }
+
+    bool filled(int x, int y) const { return (rows[y] >> x) & 1u; }
+
+    void set(int x, int y, uint32_t color) {
+        rows[y] |= static_cast<Mask>(Mask(1) << x);
+        colors[y * W + x] = color;
+        columnTops[x] = std::min(columnTops[x], y);
+    }
+
+    int clearFullRows(int from, int to) {
+        std::array<int, H> cleared; // lowest first
+        int count = 0;
+        int write = to;
+        for (int y = to; y >= 0; --y) {
+            if (y >= from && rows[y] == BasicBoard<W, H>::FULL_ROW) {
+                cleared[count++] = y;
+                continue;
+            }
+            if (write != y) {
+                rows[write] = rows[y];
+                std::copy_n(&colors[y * W], W, &colors[write * W]);
+            }
+            --write;
+        }
+        int removed = write + 1;
+        for (; write >= 0; --write) {
+            rows[write] = 0;
+        }
+        for (int x = 0; x < W; ++x) {
+            int top = columnTops[x];
+            if (top == H) continue;
+            int below = 0;
+            bool topCleared = false;
+            for (int i = 0; i < count; ++i) {
+                below += cleared[i] > top;
+                topCleared |= cleared[i] == top;
+            }
+            if (!topCleared) {
+                columnTops[x] = top + below;
+                continue;
+            }
+            while (top < H && !filled(x, top)) ++top;
+            columnTops[x] = top;
+        }
+        return removed;
+    }
+};
+
+// What the two clock reads around one timed clear cost on their own
+inline double clockPairSeconds() {
+    const int SAMPLES = 100000;
+    auto elapsed = std::chrono::steady_clock::duration::zero();
+    for (int i = 0; i < SAMPLES; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        elapsed += std::chrono::steady_clock::now() - start;
+    }
+    return std::chrono::duration<double>(elapsed).count() / SAMPLES;
+}
+
+// Keeps the stack at a constant height: fills four rows inside it (the bottom four with `bottom`),
+// times clearing them, then tops the stack back up. Returns seconds spent in clearFullRows alone,
+// which keeps the column heights current on both boards.
+template<class BoardT>
+double timeStressClears(BoardT& board, long long count, int stackTop, uint32_t seed, bool bottom) {
+    const int W = BoardT::WIDTH, H = BoardT::HEIGHT;
+    std::mt19937 rng(seed);
+    auto elapsed = std::chrono::steady_clock::duration::zero();
+    for (long long i = 0; i < count; ++i) {
+        int first = bottom ? H - 4 : stackTop + static_cast<int>(rng() % (H - 3 - stackTop));
+        for (int y = first; y < first + 4; ++y) {
+            for (int x = 0; x < W; ++x) {
+                if (!board.filled(x, y)) board.set(x, y, 0xFFFFFFFF);
+            }
+        }
+        auto start = std::chrono::steady_clock::now();
+        int removed = board.clearFullRows(first, first + 3);
+        elapsed += std::chrono::steady_clock::now() - start;
+        for (int y = stackTop; y < stackTop + removed; ++y) {
+            fillStressRow(board, y, rng);
+        }
+    }
+    return std::chrono::duration<double>(elapsed).count();
+}
+
+template<int W, int H>
+void runStressSize(const StressOptions& options) {
+    using Engine = BasicEngine<W, H>;
+    using BoardT = BasicBoard<W, H>;
+    std::cout << "size: " << W << "x" << H << " (" << sizeof(typename BoardT::Mask) * 8 << "-bit rows)" << std::endl;
+
+    // Boards this size are too big for the stack
+    auto engine = std::make_unique<Engine>(options.seed);
+    std::mt19937 rng(options.seed);
+    int stackTop = H - std::max(8, static_cast<int>(H * options.fill));
+    for (int y = stackTop; y < H; ++y) {
+        fillStressRow(engine->board, y, rng);
+    }
+
+    // Collision checks: every shape and rotation at scattered positions over the whole board
+    const long long positions = static_cast<long long>(W + 3) * (H + 2);
+    long long fits = 0;
+    double collisionSeconds = timeLoop(options.iterations, [&](long long i) {
+        long long pos = (i / 28 * 2654435761LL) % positions;
+        Piece piece{SHAPE_NAMES[i % 7], static_cast<int>((i / 7) % 4), 0, static_cast<int>(pos % (W + 3)) - 2,
+                    static_cast<int>(pos / (W + 3)) - 2};
+        fits += engine->validPosition(piece);
+    });
+    std::cout << "collision: " << options.iterations / collisionSeconds / 1e6 << " M checks/s (" << fits << " fit)" << std::endl;
+
+    // Four-line clears inside a stack filling most of the board, first anywhere in it, then at its
+    // bottom, both clears on identical boards
+    double clockSeconds = clockPairSeconds();
+    for (bool bottom : {false, true}) {
+        auto flat = std::make_unique<FlatBoard<W, H>>(engine->board);
+        double ringSeconds = timeStressClears(engine->board, options.clears, stackTop, options.seed, bottom);
+        double copySeconds = timeStressClears(*flat, options.clears, stackTop, options.seed, bottom);
+        double ringNs = std::max(0.0, ringSeconds / options.clears - clockSeconds) * 1e9;
+        double copyNs = std::max(0.0, copySeconds / options.clears - clockSeconds) * 1e9;
+        std::cout << (bottom ? "clear, bottom rows: " : "clear, anywhere: ") << ringNs << " ns (clearFullRows), " << copyNs
+                  << " ns (row-by-row copy), speedup " << (ringNs > 0 ? copyNs / ringNs : 0) << "x, clock reads excluded" << std::endl;
+    }
+
+    // Whole games on random inputs, as the headless runner plays them
+    long long pieces = 0, lines = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long long g = 0; g < options.games; ++g) {
+        uint32_t seed = options.seed + static_cast<uint32_t>(g);
+        engine->reset(seed);
+        std::mt19937 inputRng(seed ^ 0x9E3779B9u);
+        std::uniform_int_distribution<int> inputDist(0, 5);
+        int frame = 0;
+        while (!engine->gameOver && engine->blocksPlaced < options.maxPieces) {
+            bool locked = engine->apply(static_cast<Input>(inputDist(inputRng)));
+            if (!locked && !engine->gameOver && ++frame % 4 == 0) {
+                engine->stepDown();
+            }
+        }
+        pieces += engine->blocksPlaced;
+        lines += engine->linesCleared;
+    }
+    double gameSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "games: " << options.games << ", pieces " << pieces << ", lines " << lines << ", "
+              << (gameSeconds > 0 ? pieces / gameSeconds : 0) << " pieces/s" << std::endl;
+}
+
+inline int runStress(int argc, char** argv) {
+    StressOptions options = parseStressOptions(argc, argv);
+    bool ran = false;
+    auto run = [&](const char* name, auto body) {
+        if (options.size.empty() || options.size == name) {
+            body();
+            ran = true;
+        }
+    };
+    run("10x20", [&]() { runStressSize<10, 20>(options); });
+    run("16x40", [&]() { runStressSize<16, 40>(options); });
+    run("32x100", [&]() { runStressSize<32, 100>(options); });
+    run("64x1000", [&]() { runStressSize<64, 1000>(options); });
+    if (!ran) {
+        std::cerr << "Unknown board size " << options.size << " (10x20, 16x40, 32x100 or 64x1000)" << std::endl;
+        return 1;
+    }
+    return 0;
+}
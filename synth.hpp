@@ -0,0 +1,104 @@
+// Procedural Tetris theme synthesis with no SFML dependency
+// Generates the melody incrementally, so it can be streamed in small chunks
+#pragma once
+
+#include "dsp.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+const int SAMPLE_RATE = 44100;
+const float NOTE_DURATION = 0.25f; // quarter note at tempo 1
+
+// Tetris theme melody frequencies, from the Arduino notes
+const std::array<float, 40> THEME_MELODY = {
+    659, 494, 523, 587, 659, 587, 523, 494,
+    440, 440, 523, 659, 587, 523,
+    494, 523, 587, 659, 523, 440, 440, 587,
+    587, 698, 880, 784, 698, 659, 523, 659,
+    587, 523, 494, 494, 523, 587, 659, 523,
+    440, 440
+};
+
+// Music speeds up 5% per level, up to 1.5x
+inline float themeTempoForLevel(int level) {
+    return std::min(1.5f, 1.0f + 0.05f * (level - 1));
+}
+
+// Renders the looping theme note by note, continuing where the previous call stopped.
+// setTempo may be called from any thread; it takes effect at the next note.
+class ThemeSynth {
+public:
+    static constexpr float MIN_TEMPO = 0.5f;
+    static constexpr float MAX_TEMPO = 4.0f;
+
+    ThemeSynth() : envelope(samplesPerNote(MIN_TEMPO)) {
+        envelope.build(noteSamples);
+    }
+
+    void setTempo(float multiplier) { requestedTempo = std::clamp(multiplier, MIN_TEMPO, MAX_TEMPO); }
+
+    void restart() {
+        note = 0;
+        sampleInNote = 0;
+        startNote();
+    }
+
+    // Whole runs of a note go through the vectorized kernel; never allocates
+    void render(int16_t* out, size_t count) {
+        size_t done = 0;
+        while (done < count) {
+            if (sampleInNote >= noteSamples) {
+                note = (note + 1) % THEME_MELODY.size();
+                sampleInNote = 0;
+                startNote();
+            }
+            int run = static_cast<int>(std::min<size_t>(count - done, noteSamples - sampleInNote));
+            renderSineNote(out + done, envelope.data(), THEME_MELODY[note], SAMPLE_RATE, sampleInNote, run, 0.3f);
+            sampleInNote += run;
+            done += run;
+        }
+    }
+
+    // Reference per-sample version with std::sin, as generateTetrisTheme used to compute it
+    static int16_t noteSample(float freq, int i, int noteSamples) {
+        float time = static_cast<float>(i) / SAMPLE_RATE;
+        float amplitude = freq > 0 ? 0.3f * std::sin(2.0f * M_PI * freq * time) : 0.0f;
+
+        // Apply envelope for smoother sound
+        float envelope = 1.0f;
+        if (i < noteSamples * 0.1f) {
+            envelope = static_cast<float>(i) / (noteSamples * 0.1f); // Attack
+        } else if (i > noteSamples * 0.8f) {
+            envelope = 1.0f - static_cast<float>(i - noteSamples * 0.8f) / (noteSamples * 0.2f); // Release
+        }
+
+        return static_cast<int16_t>(amplitude * envelope * 32767);
+    }
+
+    static int samplesPerNote(float tempo) {
+        return static_cast<int>(SAMPLE_RATE * NOTE_DURATION / tempo);
+    }
+
+private:
+    std::atomic<float> requestedTempo{1.0f};
+    size_t note = 0;
+    int sampleInNote = 0;
+    int noteSamples = samplesPerNote(1.0f);
+    Envelope envelope;
+
+    void startNote() {
+        int samples = samplesPerNote(requestedTempo);
+        if (samples != noteSamples || envelope.size() != samples) {
+            noteSamples = samples;
+            envelope.build(noteSamples);
+        }
+    }
+};
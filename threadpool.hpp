@@ -0,0 +1,144 @@
+// Fixed-size pool of worker threads for batch jobs (replay verification, searches, tuning)
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    // 0 threads means one per hardware thread
+    explicit ThreadPool(int threads = 0) {
+        int count = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+        for (int i = 0; i < count; ++i) {
+            workers.emplace_back([this]() { workLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    int size() const { return static_cast<int>(workers.size()); }
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+            unfinished++;
+        }
+        wake.notify_one();
+    }
+
+    // Blocks until every submitted task has finished
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this]() { return unfinished == 0; });
+    }
+
+    // Runs body(i) for i in [0, count) on the pool and waits. Each worker starts with its own
+    // contiguous slice of the indices; one that runs dry steals the back half of the fullest
+    // remaining slice, so uneven items balance out and workers rarely touch the same lock.
+    template<class Body>
+    void parallelFor(size_t count, Body body) {
+        const int n = size();
+        std::unique_ptr<IndexRange[]> ranges(new IndexRange[n]);
+        for (int t = 0; t < n; ++t) {
+            ranges[t].begin = count * t / n;
+            ranges[t].end = count * (t + 1) / n;
+        }
+        std::atomic<int> nextSlot{0};
+        for (int t = 0; t < n; ++t) {
+            submit([&]() {
+                const int self = nextSlot++;
+                size_t i;
+                while (true) {
+                    if (ranges[self].take(i)) body(i);
+                    else if (!steal(ranges.get(), n, self)) return;
+                }
+            });
+        }
+        wait();
+    }
+
+private:
+    // One worker's share of a parallelFor, on its own cache line
+    struct alignas(64) IndexRange {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+
+        bool take(size_t& index) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (begin == end) return false;
+            index = begin++;
+            return true;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<std::function<void()>> tasks;
+    size_t unfinished = 0;
+    bool stopping = false;
+
+    // Moves the back half of the largest other range to ranges[self]; false when all are empty
+    static bool steal(IndexRange* ranges, int n, int self) {
+        int victim = -1;
+        size_t most = 0;
+        for (int k = 1; k < n; ++k) {
+            int t = (self + k) % n;
+            std::lock_guard<std::mutex> lock(ranges[t].mutex);
+            if (ranges[t].end - ranges[t].begin > most) {
+                most = ranges[t].end - ranges[t].begin;
+                victim = t;
+            }
+        }
+        if (victim < 0) return false;
+        size_t begin, end;
+        {
+            std::lock_guard<std::mutex> lock(ranges[victim].mutex);
+            if (ranges[victim].begin == ranges[victim].end) return true; // drained meanwhile, look again
+            end = ranges[victim].end;
+            begin = end - (end - ranges[victim].begin + 1) / 2;
+            ranges[victim].end = begin;
+        }
+        std::lock_guard<std::mutex> lock(ranges[self].mutex);
+        ranges[self].begin = begin;
+        ranges[self].end = end;
+        return true;
+    }
+
+    void workLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            std::function<void()> task = std::move(tasks.front());
+            tasks.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+            if (--unfinished == 0) {
+                idle.notify_all();
+            }
+        }
+    }
+};
@@ -0,0 +1,251 @@
+// Weight tuner: evolves the bot's evaluation weights with the cross-entropy method.
+// Each generation samples a population of weight vectors, plays the same seeded games with
+// every one of them across all cores, and refits the sampling distribution to the best few.
+// Usage: tetris --headless --tune [--generations N] [--population P] [--games G]
+//                                 [--max-pieces M] [--threads T] [--seed S] [--checkpoint FILE]
+#pragma once
+
+#include "ai.hpp"
+#include "binio.hpp"
+#include "savegame.hpp"
+#include "threadpool.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+const int WEIGHT_COUNT = 4;
+using WeightVector = std::array<float, WEIGHT_COUNT>;
+
+inline BotWeights toBotWeights(const WeightVector& v) {
+    BotWeights weights;
+    weights.aggregateHeight = v[0];
+    weights.linesCleared = v[1];
+    weights.holes = v[2];
+    weights.bumpiness = v[3];
+    return weights;
+}
+
+// Only the direction of the weights changes which placement wins, so samples are kept at unit length
+inline WeightVector normalized(WeightVector v) {
+    float length = std::sqrt(std::inner_product(v.begin(), v.end(), v.begin(), 0.0f));
+    if (length > 0) {
+        for (float& w : v) w /= length;
+    }
+    return v;
+}
+
+struct TunerState {
+    uint32_t seed = 1;
+    uint32_t generation = 0; // generations finished
+    WeightVector mean{};
+    WeightVector sigma{1.0f, 1.0f, 1.0f, 1.0f};
+    WeightVector best{};     // the fittest sample seen so far
+    float bestFitness = -1.0f;
+};
+
+const char TUNER_MAGIC[4] = {'T', 'T', 'U', 'N'};
+const uint32_t TUNER_VERSION = 1;
+
+inline std::string encodeTunerState(const TunerState& state) {
+    std::string payload;
+    putU32(payload, state.seed);
+    putU32(payload, state.generation);
+    for (int i = 0; i < WEIGHT_COUNT; ++i) {
+        putFloat(payload, state.mean[i]);
+        putFloat(payload, state.sigma[i]);
+        putFloat(payload, state.best[i]);
+    }
+    putFloat(payload, state.bestFitness);
+
+    std::string bytes(TUNER_MAGIC, sizeof(TUNER_MAGIC));
+    putU32(bytes, TUNER_VERSION);
+    putU32(bytes, static_cast<uint32_t>(payload.size()));
+    bytes += payload;
+    putU32(bytes, fnv1a(payload.data(), payload.size()));
+    return bytes;
+}
+
+inline bool decodeTunerState(const std::string& bytes, TunerState& out) {
+    if (bytes.size() < sizeof(TUNER_MAGIC) || std::memcmp(bytes.data(), TUNER_MAGIC, sizeof(TUNER_MAGIC)) != 0) {
+        return false;
+    }
+    size_t pos = sizeof(TUNER_MAGIC);
+    uint32_t version, size, checksum;
+    if (!getU32(bytes, pos, version) || version != TUNER_VERSION) return false;
+    if (!getU32(bytes, pos, size) || size > bytes.size() - pos) return false;
+    std::string payload = bytes.substr(pos, size);
+    pos += size;
+    if (!getU32(bytes, pos, checksum) || checksum != fnv1a(payload.data(), payload.size())) return false;
+
+    TunerState state;
+    pos = 0;
+    bool ok = getU32(payload, pos, state.seed) && getU32(payload, pos, state.generation);
+    for (int i = 0; i < WEIGHT_COUNT; ++i) {
+        ok = ok && getFloat(payload, pos, state.mean[i]) && getFloat(payload, pos, state.sigma[i]) &&
+             getFloat(payload, pos, state.best[i]);
+    }
+    ok = ok && getFloat(payload, pos, state.bestFitness);
+    if (ok) out = state;
+    return ok;
+}
+
+inline bool readTunerCheckpoint(const std::string& path, TunerState& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return decodeTunerState(bytes, out);
+}
+
+// Goes through the same synced write-then-rename as the save file, so a run killed mid-write or
+// a power loss keeps the last complete checkpoint
+inline bool writeTunerCheckpoint(const std::string& path, const TunerState& state) {
+    return replaceFileDurably(path, encodeTunerState(state));
+}
+
+struct TunerOptions {
+    int generations = 20;   // total, including any finished before a resume
+    int population = 40;
+    int games = 50;         // seeded games per sample, the same seeds for the whole generation
+    int maxPieces = 500;
+    int threads = 0;        // 0 for one per core
+    float eliteFraction = 0.2f;
+    std::string checkpoint = "tuner.ckpt";
+};
+
+class WeightTuner {
+public:
+    WeightTuner(const TunerOptions& tunerOptions, const TunerState& start)
+        : options(tunerOptions), state(start), pool(tunerOptions.threads) {}
+
+    const TunerState& current() const { return state; }
+    int threads() const { return pool.size(); }
+
+    // Fitness is the average lines cleared per game; returns the population's fitness
+    std::vector<float> runGeneration(std::vector<WeightVector>& samples) {
+        // Everything random in a generation comes from (seed, generation), so a resumed run matches
+        std::seed_seq seq{state.seed, state.generation};
+        std::mt19937 rng(seq);
+        std::normal_distribution<float> gauss(0.0f, 1.0f);
+        samples.assign(options.population, WeightVector{});
+        for (WeightVector& sample : samples) {
+            for (int i = 0; i < WEIGHT_COUNT; ++i) {
+                sample[i] = state.mean[i] + state.sigma[i] * gauss(rng);
+            }
+            sample = normalized(sample);
+        }
+
+        const size_t games = static_cast<size_t>(options.games);
+        const uint32_t firstSeed = rng();
+        std::vector<int> lines(samples.size() * games);
+        pool.parallelFor(lines.size(), [&](size_t i) {
+            TetrisEngine engine(firstSeed + static_cast<uint32_t>(i % games));
+            PlacementSearch search(1, toBotWeights(samples[i / games]));
+            playBotPieces(engine, search, options.maxPieces);
+            lines[i] = engine.linesCleared;
+        });
+
+        std::vector<float> fitness(samples.size());
+        for (size_t s = 0; s < samples.size(); ++s) {
+            long long total = std::accumulate(lines.begin() + s * games, lines.begin() + (s + 1) * games, 0LL);
+            fitness[s] = static_cast<float>(total) / games;
+        }
+        refit(samples, fitness);
+        state.generation++;
+        return fitness;
+    }
+
+private:
+    TunerOptions options;
+    TunerState state;
+    ThreadPool pool;
+
+    // The new mean and spread are those of the elite samples, plus a little noise that fades
+    // over the first generations so the distribution doesn't collapse early
+    void refit(const std::vector<WeightVector>& samples, const std::vector<float>& fitness) {
+        std::vector<size_t> order(samples.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return fitness[a] > fitness[b]; });
+        if (fitness[order[0]] > state.bestFitness) {
+            state.bestFitness = fitness[order[0]];
+            state.best = samples[order[0]];
+        }
+
+        size_t elite = std::max<size_t>(2, static_cast<size_t>(samples.size() * options.eliteFraction));
+        elite = std::min(elite, samples.size());
+        float noise = std::max(0.0f, 0.1f - 0.01f * state.generation);
+        for (int i = 0; i < WEIGHT_COUNT; ++i) {
+            float sum = 0, squares = 0;
+            for (size_t k = 0; k < elite; ++k) {
+                float w = samples[order[k]][i];
+                sum += w;
+                squares += w * w;
+            }
+            float mean = sum / elite;
+            state.mean[i] = mean;
+            state.sigma[i] = std::sqrt(std::max(0.0f, squares / elite - mean * mean)) + noise;
+        }
+    }
+};
+
+inline void printWeights(const WeightVector& w) {
+    std::cout << "height " << w[0] << ", lines " << w[1] << ", holes " << w[2] << ", bumpiness " << w[3];
+}
+
+inline int runTuner(int argc, char** argv) {
+    TunerOptions options;
+    TunerState start;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--generations" && hasValue) options.generations = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--population" && hasValue) options.population = std::max(2, std::atoi(argv[++i]));
+        else if (arg == "--games" && hasValue) options.games = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--max-pieces" && hasValue) options.maxPieces = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads" && hasValue) options.threads = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--seed" && hasValue) start.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--checkpoint" && hasValue) options.checkpoint = argv[++i];
+    }
+
+    if (std::filesystem::exists(options.checkpoint)) {
+        if (!readTunerCheckpoint(options.checkpoint, start)) {
+            std::cerr << "Could not read tuner checkpoint " << options.checkpoint << std::endl;
+            return 1;
+        }
+        std::cout << "resuming " << options.checkpoint << " after generation " << start.generation << std::endl;
+    }
+
+    WeightTuner tuner(options, start);
+    std::cout << "tuning with " << tuner.threads() << " threads, " << options.population << " samples x "
+              << options.games << " games per generation" << std::endl;
+    std::vector<WeightVector> samples;
+    while (static_cast<int>(tuner.current().generation) < options.generations) {
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<float> fitness = tuner.runGeneration(samples);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        if (!writeTunerCheckpoint(options.checkpoint, tuner.current())) {
+            std::cerr << "Failed to write tuner checkpoint " << options.checkpoint << std::endl;
+        }
+
+        float average = std::accumulate(fitness.begin(), fitness.end(), 0.0f) / fitness.size();
+        std::cout << "generation " << tuner.current().generation << ": best " << *std::max_element(fitness.begin(), fitness.end())
+                  << " lines, average " << average << ", " << samples.size() * options.games / seconds << " games/sec, mean ";
+        printWeights(tuner.current().mean);
+        std::cout << std::endl;
+    }
+
+    std::cout << "best " << tuner.current().bestFitness << " lines: ";
+    printWeights(tuner.current().best);
+    std::cout << std::endl;
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Retained UI text: strings are only rebuilt when the value behind them changes
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <functional>
+#include <string>
+
+// sf::Text string changes since the last reset; each one re-lays out the glyphs
+inline int uiTextRebuilds = 0;
+
+// Characters of room ValueLabel keeps in each of its buffers
+const size_t LABEL_CAPACITY = 32;
+
+// Keeps an sf::Text in sync with an integer value (bools as 0/1).
+// The last value is remembered, so update() is just a compare on unchanged frames.
+// The formatted text, the sf::String it is converted into and the text's own copy all keep room
+// for LABEL_CAPACITY characters, so a change doesn't allocate either unless the text outgrows that.
+
+class ValueLabel {
+public:
+    ValueLabel() = default;
+    explicit ValueLabel(std::function<void(std::string&, int)> formatter) : format(std::move(formatter)) {}
+
+    // Returns true if the text was changed
+    bool update(sf::Text& text, int value) {
+        if (!format || (valid && value == current)) {
+            return false;
+        }
+        if (!valid) {
+            // Grows every buffer once up front; later, longer values then fit without reallocating
+            std::u32string room(LABEL_CAPACITY, U' ');
+            formatted.reserve(LABEL_CAPACITY);
+            converted = room;
+            text.setString(converted);
+        }
+        valid = true;
+        current = value;
+        formatted.clear();
+        format(formatted, value);
+        // Built one character at a time: a single-character sf::String fits its small-string buffer,
+        // while converting the whole std::string would allocate a fresh one every time
+        converted.clear();
+        for (char c : formatted) {
+            converted += sf::String(static_cast<char32_t>(static_cast<unsigned char>(c)));
+        }
+        text.setString(converted);
+        ++uiTextRebuilds;
+        return true;
+    }
+
+    void invalidate() { valid = false; }
+
+private:
+    std::function<void(std::string&, int)> format;
+    bool valid = false;
+    int current = 0;
+    std::string formatted;
+    sf::String converted;
+};
+
+// Decimal digits appended without a temporary string
+inline void appendInt(std::string& out, int value) {
+    char digits[12];
+    unsigned magnitude = value < 0 ? 0u - static_cast<unsigned>(value) : static_cast<unsigned>(value);
+    int n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) out += '-';
+    while (n) out += digits[--n];
+}
+
+inline ValueLabel prefixedLabel(const std::string& prefix, const std::string& suffix = "") {
+    return ValueLabel([prefix, suffix](std::string& out, int value) {
+        out += prefix;
+        appendInt(out, value);
+        out += suffix;
+    });
+}
+
+inline ValueLabel toggleLabel(const std::string& name) {
+    return ValueLabel([name](std::string& out, int on) {
+        out += name;
+        out += on ? ": On" : ": Off";
+    });
+}
@@ -0,0 +1,102 @@
+// Batch replay verifier: re-simulates every replay in a directory and flags claimed
+// results (score, lines, level, end tick) that the engine does not reproduce.
+// Usage: tetris --headless --verify-replays DIR [--threads T]
+#pragma once
+
+#include "replay.hpp"
+#include "threadpool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct ReplayVerdict {
+    enum Status { Verified, Mismatch, Unreadable } status = Unreadable;
+    uint64_t ticks = 0;
+    int score = 0;
+    int linesCleared = 0;
+    int level = 0;
+    Replay claimed; // header and totals only, the events are dropped once played
+};
+
+inline ReplayVerdict verifyReplayFile(const std::string& path) {
+    ReplayVerdict verdict;
+    if (!readReplayFile(path, verdict.claimed)) {
+        return verdict;
+    }
+    // No seeking here, so one keyframe (the start) is all the player needs to keep
+    ReplayPlayer player(verdict.claimed, UINT64_MAX);
+    player.runToEnd();
+    const TetrisEngine& state = player.state();
+    verdict.ticks = player.currentTick();
+    verdict.score = state.score;
+    verdict.linesCleared = state.linesCleared;
+    verdict.level = state.level;
+    verdict.status = player.matchesClaim() ? ReplayVerdict::Verified : ReplayVerdict::Mismatch;
+    verdict.claimed.events.clear();
+    verdict.claimed.events.shrink_to_fit();
+    return verdict;
+}
+
+inline int runReplayVerifier(int argc, char** argv) {
+    std::string dir;
+    int threads = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--verify-replays" && hasValue) dir = argv[++i];
+        else if (arg == "--threads" && hasValue) threads = std::max(1, std::atoi(argv[++i]));
+    }
+
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, error)) {
+        if (entry.is_regular_file() && entry.path().extension() == REPLAY_EXTENSION) {
+            paths.push_back(entry.path().string());
+        }
+    }
+    if (error) {
+        std::cerr << "Could not read replay directory " << dir << std::endl;
+        return 1;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<ReplayVerdict> verdicts(paths.size());
+    ThreadPool pool(threads);
+    pool.parallelFor(paths.size(), [&](size_t i) { verdicts[i] = verifyReplayFile(paths[i]); });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    long long verified = 0, mismatched = 0, unreadable = 0, ticks = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        const ReplayVerdict& v = verdicts[i];
+        ticks += v.ticks;
+        if (v.status == ReplayVerdict::Verified) {
+            verified++;
+        } else if (v.status == ReplayVerdict::Unreadable) {
+            unreadable++;
+            std::cout << "UNREADABLE " << paths[i] << "\n";
+        } else {
+            mismatched++;
+            std::cout << "MISMATCH " << paths[i] << ": claimed score " << v.claimed.score << " lines " << v.claimed.linesCleared
+                      << " level " << v.claimed.level << ", replayed score " << v.score << " lines " << v.linesCleared
+                      << " level " << v.level;
+            if (v.ticks != v.claimed.endTick) {
+                std::cout << ", claimed end tick " << v.claimed.endTick << " but the game ended at tick " << v.ticks;
+            }
+            std::cout << "\n";
+        }
+    }
+
+    std::cout << "replays: " << paths.size() << "\n"
+              << "verified: " << verified << "\n"
+              << "mismatched: " << mismatched << "\n"
+              << "unreadable: " << unreadable << "\n"
+              << "threads: " << pool.size() << "\n"
+              << "seconds: " << seconds << "\n"
+              << "replays/sec: " << (seconds > 0 ? paths.size() / seconds : 0) << "\n"
+              << "ticks/sec: " << (seconds > 0 ? ticks / seconds : 0) << std::endl;
+    return mismatched == 0 && unreadable == 0 ? 0 : 1;
+}